@@ -0,0 +1,161 @@
+#pragma once
+
+#include "AffineKernel.h"
+#include <cmath>
+#include <numbers>
+#include <type_traits>
+
+namespace detail {
+
+// Return sin(x) and cos(x) in a way that can be used during constant evaluation.
+// This is only used at compile time; at run time std::sin and std::cos are used.
+constexpr void constexpr_sin_cos(double x, double& sine, double& cosine)
+{
+  // Reduce x to [-π, π].
+  double const two_pi = 2.0 * std::numbers::pi;
+  while (x > std::numbers::pi)
+    x -= two_pi;
+  while (x < -std::numbers::pi)
+    x += two_pi;
+
+  // Taylor series; 30 terms are more than enough for |x| <= π.
+  double const x2 = x * x;
+  double term_sin = x;
+  double term_cos = 1.0;
+  sine = term_sin;
+  cosine = term_cos;
+  for (int n = 1; n < 30; ++n)
+  {
+    term_sin *= -x2 / ((2 * n) * (2 * n + 1));
+    term_cos *= -x2 / ((2 * n - 1) * (2 * n));
+    sine += term_sin;
+    cosine += term_cos;
+  }
+}
+
+} // namespace detail
+
+// A 2x3 affine matrix, using the same conventions as QTransform:
+// points are row vectors that are multiplied from the left,
+//
+//   [x' y' 1] = [x y 1] ⎛m11 m12 0⎞
+//                       ⎜m21 m22 0⎟
+//                       ⎝dx  dy  1⎠
+//
+// and translate, scale and rotate apply the new operation before the existing ones.
+class AffineTransform
+{
+ private:
+  double m11_ = 1.0;
+  double m12_ = 0.0;
+  double m21_ = 0.0;
+  double m22_ = 1.0;
+  double dx_ = 0.0;
+  double dy_ = 0.0;
+
+ public:
+  // Construct the identity transform.
+  constexpr AffineTransform() = default;
+  constexpr AffineTransform(double m11, double m12, double m21, double m22, double dx, double dy) :
+    m11_(m11), m12_(m12), m21_(m21), m22_(m22), dx_(dx), dy_(dy) { }
+
+  static constexpr AffineTransform from_translate(double dx, double dy) { return {1.0, 0.0, 0.0, 1.0, dx, dy}; }
+  static constexpr AffineTransform from_scale(double sx, double sy) { return {sx, 0.0, 0.0, sy, 0.0, 0.0}; }
+
+  constexpr double m11() const { return m11_; }
+  constexpr double m12() const { return m12_; }
+  constexpr double m21() const { return m21_; }
+  constexpr double m22() const { return m22_; }
+  constexpr double dx() const { return dx_; }
+  constexpr double dy() const { return dy_; }
+
+  constexpr AffineCoefficients coefficients() const { return {m11_, m12_, m21_, m22_, dx_, dy_}; }
+
+  constexpr AffineTransform& translate(double dx, double dy)
+  {
+    dx_ += dx * m11_ + dy * m21_;
+    dy_ += dx * m12_ + dy * m22_;
+    return *this;
+  }
+
+  constexpr AffineTransform& scale(double sx, double sy)
+  {
+    m11_ *= sx;
+    m12_ *= sx;
+    m21_ *= sy;
+    m22_ *= sy;
+    return *this;
+  }
+
+  // Rotate over `degrees` degrees. Multiples of 90 degrees are exact.
+  constexpr AffineTransform& rotate(double degrees)
+  {
+    if (degrees == 0.0)
+      return *this;
+
+    double sina = 0.0;
+    double cosa = 0.0;
+    if (degrees == 90.0 || degrees == -270.0)
+      sina = 1.0;
+    else if (degrees == 270.0 || degrees == -90.0)
+      sina = -1.0;
+    else if (degrees == 180.0 || degrees == -180.0)
+      cosa = -1.0;
+    else
+    {
+      double const radians = degrees * (std::numbers::pi / 180.0);
+      if (std::is_constant_evaluated())
+        detail::constexpr_sin_cos(radians, sina, cosa);
+      else
+      {
+        sina = std::sin(radians);
+        cosa = std::cos(radians);
+      }
+    }
+
+    double const m11 = cosa * m11_ + sina * m21_;
+    double const m12 = cosa * m12_ + sina * m22_;
+    double const m21 = -sina * m11_ + cosa * m21_;
+    double const m22 = -sina * m12_ + cosa * m22_;
+    m11_ = m11;
+    m12_ = m12;
+    m21_ = m21;
+    m22_ = m22;
+    return *this;
+  }
+
+  constexpr double determinant() const { return m11_ * m22_ - m12_ * m21_; }
+
+  // Return the inverse. The matrix must be invertible (determinant() != 0).
+  constexpr AffineTransform inverted() const
+  {
+    double const det = determinant();
+    return {
+      m22_ / det, -m12_ / det,
+      -m21_ / det, m11_ / det,
+      (m21_ * dy_ - m22_ * dx_) / det, (m12_ * dx_ - m11_ * dy_) / det
+    };
+  }
+
+  // Map the point (x, y).
+  constexpr double map_x(double x, double y) const { return m11_ * x + m21_ * y + dx_; }
+  constexpr double map_y(double x, double y) const { return m12_ * x + m22_ * y + dy_; }
+
+  // Return the transform that first applies *this and then rhs.
+  constexpr AffineTransform operator*(AffineTransform const& rhs) const
+  {
+    return {
+      m11_ * rhs.m11_ + m12_ * rhs.m21_, m11_ * rhs.m12_ + m12_ * rhs.m22_,
+      m21_ * rhs.m11_ + m22_ * rhs.m21_, m21_ * rhs.m12_ + m22_ * rhs.m22_,
+      dx_ * rhs.m11_ + dy_ * rhs.m21_ + rhs.dx_, dx_ * rhs.m12_ + dy_ * rhs.m22_ + rhs.dy_
+    };
+  }
+
+  constexpr AffineTransform& operator*=(AffineTransform const& rhs)
+  {
+    *this = *this * rhs;
+    return *this;
+  }
+
+  friend constexpr bool operator==(AffineTransform const& lhs, AffineTransform const& rhs) = default;
+};
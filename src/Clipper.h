@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Point.h"
+#include "Line.h"
+#include "Rectangle.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include "debug.h"
+
+// Clipping of infinite lines against an axis-aligned rectangle (Liang–Barsky).
+//
+// The line point + t * direction is inside the rectangle for t_enter <= t <= t_exit. Because t increases
+// in the direction of the line, the point at t_enter is on the negative side and the point at t_exit on the
+// positive side: the returned points are always ordered like the direction of the line.
+//
+// Nothing is allocated; the batched version writes to caller provided storage.
+
+namespace clipper {
+
+// The axis-aligned bounds of a rectangle.
+struct Bounds
+{
+  double x_min;
+  double y_min;
+  double x_max;
+  double y_max;
+
+  template<CS cs>
+  Bounds(Rectangle<cs> const& rectangle) :
+    x_min(rectangle.offset_x()), y_min(rectangle.offset_y()),
+    x_max(rectangle.offset_x() + rectangle.width()), y_max(rectangle.offset_y() + rectangle.height()) { }
+};
+
+namespace detail {
+
+// Narrow [t_enter, t_exit] to the values of t for which lo <= p + t * d <= hi.
+inline void clip_slab(double p, double d, double lo, double hi, double& t_enter, double& t_exit)
+{
+  if (d == 0.0)
+  {
+    // Parallel to the slab: either entirely inside or entirely outside of it.
+    if (p < lo || p > hi)
+      t_exit = -std::numeric_limits<double>::infinity();
+    return;
+  }
+  double const t_lo = (lo - p) / d;
+  double const t_hi = (hi - p) / d;
+  t_enter = std::max(t_enter, std::min(t_lo, t_hi));
+  t_exit = std::min(t_exit, std::max(t_lo, t_hi));
+}
+
+} // namespace detail
+
+// Clip the infinite line through (px, py) with direction (dx, dy) against bounds.
+// Returns true and sets t_enter < t_exit if a part of the line with non-zero length is inside bounds.
+// A line that only touches a corner, or that does not intersect with bounds at all, returns false.
+inline bool clip(double px, double py, double dx, double dy, Bounds const& bounds, double& t_enter, double& t_exit)
+{
+  t_enter = -std::numeric_limits<double>::infinity();
+  t_exit = std::numeric_limits<double>::infinity();
+  detail::clip_slab(px, dx, bounds.x_min, bounds.x_max, t_enter, t_exit);
+  detail::clip_slab(py, dy, bounds.y_min, bounds.y_max, t_enter, t_exit);
+  return t_enter < t_exit;
+}
+
+// Clip line against rectangle. Returns the number of points written to piece: 2 if the line is visible, 0 otherwise.
+// The caller is responsible to make sure that the line and rectangle use the coordinate system cs.
+template<CS cs>
+int clip(Line<cs> const& line, Rectangle<cs> const& rectangle, std::array<Point<cs>, 2>& piece)
+{
+  double const px = line.point().x();
+  double const py = line.point().y();
+  double const dx = line.direction().x();
+  double const dy = line.direction().y();
+  double t_enter, t_exit;
+  if (!clip(px, py, dx, dy, rectangle, t_enter, t_exit))
+    return 0;
+  piece = {Point<cs>{px + t_enter * dx, py + t_enter * dy}, Point<cs>{px + t_exit * dx, py + t_exit * dy}};
+  return 2;
+}
+
+// Clip every line of lines against rectangle.
+//
+// The visible pieces are written, in the order of lines, to the start of pieces, and the index
+// into lines of each of them to the same position in indices. Both spans must be at least as
+// large as lines. Returns the number of visible pieces.
+template<CS cs>
+std::size_t clip(std::span<Line<cs> const> lines, Rectangle<cs> const& rectangle,
+    std::span<std::array<Point<cs>, 2>> pieces, std::span<std::size_t> indices)
+{
+  ASSERT(pieces.size() >= lines.size() && indices.size() >= lines.size());
+  Bounds const bounds(rectangle);
+  std::size_t visible = 0;
+  for (std::size_t i = 0; i < lines.size(); ++i)
+  {
+    double const px = lines[i].point().x();
+    double const py = lines[i].point().y();
+    double const dx = lines[i].direction().x();
+    double const dy = lines[i].direction().y();
+    double t_enter, t_exit;
+    bool const is_visible = clip(px, py, dx, dy, bounds, t_enter, t_exit);
+    // Always write, but only advance the output position for visible lines.
+    pieces[visible] = {Point<cs>{px + t_enter * dx, py + t_enter * dy}, Point<cs>{px + t_exit * dx, py + t_exit * dy}};
+    indices[visible] = i;
+    visible += is_visible;
+  }
+  return visible;
+}
+
+} // namespace clipper
@@ -0,0 +1,229 @@
+#include "sys.h"
+#include "Clipper.h"
+#include "LineBatch.h"
+#include "Stopwatch.h"
+#include "cairowindow/intersection_points.h"
+#include "math/Hyperblock.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <vector>
+#include "debug.h"
+
+// Cross-check clipper::clip against math::Hyperblock<2>::intersection_points for random lines,
+// check that the batched version and the fused clip_and_map pipeline give the same results, and time them.
+
+namespace {
+
+constexpr double x_min = 0.0;
+constexpr double y_min = 0.0;
+constexpr double x_max = window_width;
+constexpr double y_max = window_height;
+
+// What detail::intersect used to do.
+int reference_clip(Line<CS::pixels> const& line, std::array<Point<CS::pixels>, 2>& piece)
+{
+  double const normal_x = -line.direction().y();
+  double const normal_y = line.direction().x();
+  math::Hyperplane<2> plane({normal_x, normal_y}, -(normal_x * line.point().x() + normal_y * line.point().y()));
+  math::Hyperblock<2> rectangle({x_min, y_min}, {x_max, y_max});
+  auto intersections = rectangle.intersection_points(plane);
+  if (intersections.size() < 2)
+    return 0;
+  piece = {Point<CS::pixels>{intersections[0][0], intersections[0][1]}, Point<CS::pixels>{intersections[1][0], intersections[1][1]}};
+  // Order the points along the direction of the line.
+  auto along = [&](Point<CS::pixels> const& p){ return p.x() * line.direction().x() + p.y() * line.direction().y(); };
+  if (along(piece[0]) > along(piece[1]))
+    std::swap(piece[0], piece[1]);
+  return 2;
+}
+
+bool close(Point<CS::pixels> const& p1, Point<CS::pixels> const& p2)
+{
+  return std::abs(p1.x() - p2.x()) < 1e-9 && std::abs(p1.y() - p2.y()) < 1e-9;
+}
+
+// A line that lies on the border of the window.
+bool on_border(Line<CS::pixels> const& line)
+{
+  return (line.direction().y() == 0.0 && (line.point().y() == y_min || line.point().y() == y_max)) ||
+    (line.direction().x() == 0.0 && (line.point().x() == x_min || line.point().x() == x_max));
+}
+
+// A piece that is so short that rounding errors can make its line miss the window (it passes within that distance of a corner).
+bool almost_touches(Point<CS::pixels> const& from, Point<CS::pixels> const& to)
+{
+  return std::abs(from.x() - to.x()) < 1e-6 && std::abs(from.y() - to.y()) < 1e-6;
+}
+
+} // namespace
+
+int main()
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  constexpr int number_of_lines = 100000;
+  constexpr int repeat = 10;
+
+  Rectangle<CS::pixels> const window{x_min, y_min, x_max - x_min, y_max - y_min};
+
+  // Random lines through a region three times as large as the window, so that many miss it.
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> x_distribution(-x_max, 2 * x_max);
+  std::uniform_real_distribution<double> y_distribution(-y_max, 2 * y_max);
+  std::uniform_real_distribution<double> angle_distribution(0.0, 2 * std::numbers::pi);
+  std::vector<Line<CS::pixels>> lines;
+  lines.reserve(number_of_lines);
+  for (int i = 0; i < number_of_lines; ++i)
+  {
+    double const angle = angle_distribution(engine);
+    lines.emplace_back(cairowindow::Point{x_distribution(engine), y_distribution(engine)}, cairowindow::Direction{std::cos(angle), std::sin(angle)});
+  }
+  // Axis-aligned lines, including ones on the border of the window, and a line through a corner.
+  lines.emplace_back(cairowindow::Point{0.0, 100.0}, cairowindow::Direction{1.0, 0.0});
+  lines.emplace_back(cairowindow::Point{100.0, 0.0}, cairowindow::Direction{0.0, -1.0});
+  lines.emplace_back(cairowindow::Point{-10.0, 100.0}, cairowindow::Direction{0.0, 1.0});
+  lines.emplace_back(cairowindow::Point{0.0, y_max}, cairowindow::Direction{-1.0, 0.0});
+  lines.emplace_back(cairowindow::Point{x_max + 1.0, y_max - 1.0}, cairowindow::Direction{std::sqrt(0.5), -std::sqrt(0.5)});
+
+  std::vector<std::array<Point<CS::pixels>, 2>> pieces(lines.size());
+  std::vector<std::size_t> indices(lines.size());
+  std::size_t const visible = clipper::clip<CS::pixels>(lines, window, pieces, indices);
+
+  int failures = 0;
+  std::size_t batched = 0;
+  for (std::size_t i = 0; i < lines.size(); ++i)
+  {
+    std::array<Point<CS::pixels>, 2> expected;
+    std::array<Point<CS::pixels>, 2> piece;
+    int const expected_count = reference_clip(lines[i], expected);
+    int const count = clipper::clip(lines[i], window, piece);
+    // A line that only touches the rectangle, or that lies on its border, may go either way.
+    bool const degenerate = on_border(lines[i]) || (expected_count == 2 && close(expected[0], expected[1]));
+    if (!degenerate && (count != expected_count || (count == 2 && !(close(piece[0], expected[0]) && close(piece[1], expected[1])))))
+    {
+      if (failures++ < 10)
+        std::cerr << "Line " << i << ": expected " << expected_count << " points, got " << count << std::endl;
+    }
+    if (count == 2)
+    {
+      if (batched >= visible || indices[batched] != i || !close(pieces[batched][0], piece[0]) || !close(pieces[batched][1], piece[1]))
+      {
+        if (failures++ < 10)
+          std::cerr << "Batched result for line " << i << " differs." << std::endl;
+      }
+      ++batched;
+    }
+  }
+  if (batched != visible)
+  {
+    std::cerr << "Batched clip returned " << visible << " pieces instead of " << batched << std::endl;
+    ++failures;
+  }
+
+  // The same lines, now in CS::centered, mapped to pixels and clipped in one pass.
+  Transform<CS::centered, CS::pixels> const centered_transform_pixels =
+    Transform<CS::centered, CS::pixels>{}.translate(half_window_size).scale(half_window_size.height()).rotate(30.0);
+  auto const& pixels_transform_centered = centered_transform_pixels.inverse();
+  LineArray<CS::centered> centered_lines;
+  centered_lines.reserve(lines.size());
+  for (Line<CS::pixels> const& line : lines)
+  {
+    Point<CS::centered> const point = Point<CS::pixels>{line.point()} * pixels_transform_centered;
+    Point<CS::centered> const ahead = Point<CS::pixels>{line.point().x() + line.direction().x(), line.point().y() + line.direction().y()} *
+      pixels_transform_centered;
+    centered_lines.push_back(point, Vector<CS::centered>{point, ahead});
+  }
+  LinePieceArray<CS::pixels> mapped_pieces;
+  std::size_t const mapped_visible = clipper::clip_and_map(centered_lines, centered_transform_pixels, window, mapped_pieces);
+  // After the round trip through CS::centered, lines on the border of the window, and lines that pass
+  // (almost) through a corner, may go either way. All other lines must be visible in both passes or in neither.
+  std::size_t matched = 0;
+  std::size_t ambiguous = 0;
+  for (std::size_t i = 0, j = 0, k = 0; i < lines.size(); ++i)
+  {
+    bool const direct_visible = j < visible && indices[j] == i;
+    bool const mapped_visible_i = k < mapped_visible && mapped_pieces.index(k) == i;
+    bool const is_ambiguous = on_border(lines[i]) ||
+      (direct_visible && almost_touches(pieces[j][0], pieces[j][1])) ||
+      (mapped_visible_i && almost_touches(mapped_pieces.from()[k], mapped_pieces.to()[k]));
+    if (direct_visible && mapped_visible_i)
+    {
+      auto tolerant = [](Point<CS::pixels> const& p1, Point<CS::pixels> const& p2){
+        return std::abs(p1.x() - p2.x()) < 1e-6 && std::abs(p1.y() - p2.y()) < 1e-6; };
+      if (!tolerant(mapped_pieces.from()[k], pieces[j][0]) || !tolerant(mapped_pieces.to()[k], pieces[j][1]))
+      {
+        if (failures++ < 10)
+          std::cerr << "clip_and_map result for line " << i << " differs." << std::endl;
+      }
+      ++matched;
+    }
+    else if (direct_visible != mapped_visible_i)
+    {
+      if (is_ambiguous)
+        ++ambiguous;
+      else if (failures++ < 10)
+        std::cerr << "Line " << i << " is " << (direct_visible ? "" : "not ") << "visible, but clip_and_map says the opposite." << std::endl;
+    }
+    j += direct_visible;
+    k += mapped_visible_i;
+  }
+
+  // A singular transform maps every direction to zero: no line is visible (rather than a piece with NaN coordinates).
+  Transform<CS::centered, CS::pixels> const singular = Transform<CS::centered, CS::pixels>{}.translate(half_window_size).scale(0.0);
+  LinePieceArray<CS::pixels> singular_pieces;
+  if (clipper::clip_and_map(centered_lines, singular, window, singular_pieces) != 0)
+  {
+    std::cerr << "clip_and_map returned visible pieces for a singular transform." << std::endl;
+    ++failures;
+  }
+
+  // Timing.
+  Stopwatch reference;
+  Stopwatch single;
+  Stopwatch batch;
+  Stopwatch fused;
+  for (int r = 0; r < repeat; ++r)
+  {
+    reference.start();
+    for (Line<CS::pixels> const& line : lines)
+    {
+      std::array<Point<CS::pixels>, 2> piece;
+      do_not_optimize(reference_clip(line, piece));
+      do_not_optimize(piece);
+    }
+    reference.stop();
+
+    single.start();
+    for (Line<CS::pixels> const& line : lines)
+    {
+      std::array<Point<CS::pixels>, 2> piece;
+      do_not_optimize(clipper::clip(line, window, piece));
+      do_not_optimize(piece);
+    }
+    single.stop();
+
+    batch.start();
+    do_not_optimize(clipper::clip<CS::pixels>(lines, window, pieces, indices));
+    batch.stop();
+
+    fused.start();
+    do_not_optimize(clipper::clip_and_map(centered_lines, centered_transform_pixels, window, mapped_pieces));
+    fused.stop();
+  }
+
+  uint64_t const total = uint64_t{lines.size()} * repeat;
+  std::cout << lines.size() << " lines, " << visible << " visible (" << mapped_visible << " after the round trip through CS::centered, " <<
+    matched << " compared, " << ambiguous << " on a border or corner); " << failures << " failures." << std::endl;
+  std::cout << "Hyperblock<2>::intersection_points: " << reference.ns_per(total) << " ns/line\n";
+  std::cout << "clipper::clip (single line):        " << single.ns_per(total) << " ns/line\n";
+  std::cout << "clipper::clip (batch):              " << batch.ns_per(total) << " ns/line\n";
+  std::cout << "clipper::clip_and_map:              " << fused.ns_per(total) << " ns/line\n";
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
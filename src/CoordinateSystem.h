@@ -4,9 +4,18 @@
 #include "Point.h"
 #include "Line.h"
 #include "Rectangle.h"
+#include "Clipper.h"
+#include "LineBatch.h"
 #include "Range.h"
 #include "Vector.h"
 #include "NiceDelta.h"
+#include "TickHierarchy.h"
+#include "TickRange.h"
+#include "DrawObjectArena.h"
+#include "DirtyRegion.h"
+#include "DrawBatch.h"
+#include "Profiler.h"
+#include "TraceBuffer.h"
 #include "cairowindow/draw/Point.h"
 #include "cairowindow/draw/PlotArea.h"          // number_of_axis, calculate_range_ticks
 #include "cairowindow/draw/Line.h"
@@ -23,6 +32,7 @@
 #include "math/Direction.h"
 #include <boost/intrusive_ptr.hpp>
 #include <cmath>
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -131,21 +141,148 @@ using LineStyle = cwin::draw::LineStyle;
 using cwin::plot::x_axis;
 using cwin::plot::y_axis;
 
+// How CoordinateSystem::display allocates its draw objects.
+enum class AllocationMode
+{
+  heap,         // Use std::make_shared for each object.
+  arena         // Allocate the objects of one display pass (except the axis lines) from a single DrawObjectArena.
+};
+
 template<CS cs>
 class CoordinateSystem
 {
   static constexpr int number_of_axes = PlotArea::number_of_axes;
   using Direction = cwin::Direction;
 
+  static constexpr int number_of_tick_levels = TickHierarchy<cs>::number_of_levels;
+  static constexpr int axis_line_level = -1;
+
+  // Level of detail: tick marks that are closer together than min_tick_spacing pixels are thinned out,
+  // and labels are thinned out until their (estimated) extent along the axis no longer overlaps.
+  // Labels are not measured (that requires a cairo context); their size is estimated from the number of characters.
+  static constexpr double min_tick_spacing = 4.0;       // The minimum distance between two tick marks, in pixels.
+  static constexpr double label_char_width = 7.0;       // The estimated width of one character of a label, in pixels.
+  static constexpr double label_height = 12.0;          // The estimated height of a label, in pixels.
+  static constexpr double label_padding = 6.0;          // The minimum space between two labels, in pixels.
+
+ public:
+  // Identifies a line or label of the drawing: the axis itself (level == axis_line_level), or tick k of a level of an axis.
+  // layout() generates the geometry in increasing order of keys.
+  struct TickKey
+  {
+    int axis;
+    int level;
+    int k;
+
+    friend auto operator<=>(TickKey const& lhs, TickKey const& rhs) = default;
+  };
+
+  // The geometry of a line that is part of the CoordinateSystem drawing (in CS::pixels).
+  struct LineGeometry
+  {
+    TickKey key;
+    Point<CS::pixels> from;
+    Point<CS::pixels> to;
+
+    // Add the pixels covered by this line, drawn with line_width, to region.
+    void add_to(DirtyRegion& region, double line_width) const
+    {
+      // One extra pixel for anti-aliasing.
+      double const margin = 0.5 * line_width + 1.0;
+      region.add(from, margin);
+      region.add(to, margin);
+    }
+
+    friend bool operator==(LineGeometry const& lhs, LineGeometry const& rhs)
+    {
+      return lhs.key == rhs.key &&
+        lhs.from.x() == rhs.from.x() && lhs.from.y() == rhs.from.y() && lhs.to.x() == rhs.to.x() && lhs.to.y() == rhs.to.y();
+    }
+  };
+
+  // The geometry of a label that is part of the CoordinateSystem drawing (in CS::pixels).
+  struct TextGeometry
+  {
+    TickKey key;
+    std::string label;
+    Point<CS::pixels> anchor;
+    cwin::draw::TextPosition position;
+    double rotation;
+
+    // Add the pixels (conservatively) covered by this label to region.
+    void add_to(DirtyRegion& region) const
+    {
+      // The label is on one side of the anchor, possibly rotated; a square around the anchor that is
+      // as large as the estimated width plus height of the label covers it in every case.
+      region.add(anchor, label.size() * label_char_width + label_height);
+    }
+
+    friend bool operator==(TextGeometry const& lhs, TextGeometry const& rhs)
+    {
+      return lhs.key == rhs.key && lhs.label == rhs.label && lhs.anchor.x() == rhs.anchor.x() && lhs.anchor.y() == rhs.anchor.y() &&
+        lhs.position == rhs.position && lhs.rotation == rhs.rotation;
+    }
+  };
+
+ private:
+  // Cache of the tick labels of one tick level of an axis.
+  // It only covers ticks of the current range: set_range trims it, so that panning doesn't make it grow without bound.
+  struct LabelCache
+  {
+    int k_first = 0;                    // The k value of the first element of labels.
+    std::deque<std::string> labels;     // The label of tick k is stored at index k - k_first. Empty means: not cached.
+
+    // Return the (possibly empty) label of tick k, adding it to the cache.
+    std::string& operator[](int k)
+    {
+      if (labels.empty())
+        k_first = k;
+      // Extend the cache at the front, without moving the existing labels.
+      for (; k < k_first; --k_first)
+        labels.emplace_front();
+      std::size_t const index = k - k_first;
+      if (index >= labels.size())
+        labels.resize(index + 1);
+      return labels[index];
+    }
+
+    // Drop the labels of ticks outside [k_min, k_max].
+    void trim(int k_min, int k_max)
+    {
+      int const k_last = k_first + static_cast<int>(labels.size()) - 1;
+      if (k_min > k_max || k_min > k_last || k_max < k_first)
+      {
+        labels.clear();
+        return;
+      }
+      for (; k_first < k_min; ++k_first)
+        labels.pop_front();
+      std::size_t const size = k_max - k_first + 1;
+      if (labels.size() > size)
+        labels.resize(size);
+    }
+  };
+
  private:
   Transform<cs, CS::pixels> cs_transform_pixels_;                       // The Transform defining this CoordinateSystem.
+  bool has_transform_;                                                  // False until a transform was passed to the constructor or set_transform.
   LineStyle axis_style_;                                                // The linestyle to use for the axes and tickmarks.
-  Point<CS::pixels> csOrigin_pixels_;                                   // The origin in pixels.
-  std::array<Direction, number_of_axes> csAxisDirection_;               // The direction of the x-axis and y-axis (in CS::pixels).
+  AllocationMode allocation_mode_ = AllocationMode::arena;              // How display allocates draw objects.
+  std::array<TickAxis<cs>, number_of_axes> tick_axis_;                 // The origin and direction of the x-axis and y-axis (in CS::pixels).
   std::vector<std::shared_ptr<cwin::draw::Line>> lines_;                // To keep drawn lines alive.
   std::vector<std::shared_ptr<cwin::draw::Text>> texts_;                // To keep drawn texts alive.
+  std::vector<std::shared_ptr<cwin::draw::Line>> previous_lines_;       // Scratch space for display (only used to reuse its capacity).
+  std::vector<std::shared_ptr<cwin::draw::Text>> previous_texts_;       // Same, for texts.
   std::array<cwin::LinePiece, number_of_axes> line_piece_;              // The visible part of the axes (in CS::pixels).
 
+  std::vector<LineGeometry> line_geometry_;                             // The lines that should be drawn, as calculated by layout().
+  std::vector<TextGeometry> text_geometry_;                             // The labels that should be drawn, as calculated by layout().
+  std::vector<LineGeometry> drawn_line_geometry_;                       // The geometry of each element of lines_.
+  std::vector<TextGeometry> drawn_text_geometry_;                       // The geometry of each element of texts_.
+  std::array<std::array<LabelCache, number_of_tick_levels>, number_of_axes> label_cache_;  // Tick labels, per axis and tick level.
+  int tick_levels_ = 1;                                                 // The number of tick levels that are drawn.
+  bool needs_display_ = false;                                          // Set when layout() ran after the last call to display.
+
  private:
   using LayerPtr = boost::intrusive_ptr<cwin::Layer>;
   using PointPtr = std::shared_ptr<Point<cs>>;
@@ -159,13 +296,41 @@ class CoordinateSystem
 /*  std::shared_ptr<Text> xlabel_;
   std::shared_ptr<Text> ylabel_;*/
   std::array<Range<cs>, number_of_axes> range_{{{0.0, 0.0}, {0.0, 0.0}}};       // Zero means: not visible.
-  std::array<NiceDelta<cs>, number_of_axes> range_ticks_;                       // The number of tick marks on the visible segment of the respective axis.
+  std::array<TickHierarchy<cs>, number_of_axes> ticks_;                         // The tick marks on the visible segment of the respective axis.
                                                                                 // Invalid (default constructed) means: don't draw ticks.
 /*  std::array<std::vector<std::shared_ptr<Text>>, number_of_axes> labels_;*/
 
  public:
   CoordinateSystem(Transform<cs, CS::pixels> const reference_transform, LineStyle axis_style);
 
+  // Construct a CoordinateSystem without a transform. Call set_transform before calling display.
+  explicit CoordinateSystem(LineStyle axis_style) : has_transform_(false), axis_style_{axis_style} { }
+
+  void set_allocation_mode(AllocationMode allocation_mode) { allocation_mode_ = allocation_mode; }
+
+  // Accessors for renderers that don't use a cairowindow::Layer (see OffscreenRenderer).
+  // The geometry is that of the last layout, which happens when the transform, a range or the number of tick levels changed.
+  LineStyle const& axis_style() const { return axis_style_; }
+  std::vector<LineGeometry> const& line_geometry() const { return line_geometry_; }
+  std::vector<TextGeometry> const& text_geometry() const { return text_geometry_; }
+
+  // Draw the tick marks of the first tick_levels levels of the TickHierarchy: 1 (the default) only draws
+  // the major ticks, 2 adds the minor ticks and 3 the sub-minor ticks. Only major ticks get a label.
+  // Call display to update the drawing.
+  void set_tick_levels(int tick_levels)
+  {
+    ASSERT(1 <= tick_levels && tick_levels <= number_of_tick_levels);
+    if (tick_levels == tick_levels_)
+      return;
+    tick_levels_ = tick_levels;
+    layout();
+  }
+
+  // Change the Transform defining this CoordinateSystem.
+  // This recalculates the axes and tick marks, but the labels are only reformatted if the NiceDelta of an axis changed.
+  // Call display to update the drawing.
+  void set_transform(Transform<cs, CS::pixels> const& cs_transform_pixels);
+
   ~CoordinateSystem()
   {
     DoutEntering(dc::notice, "CoordinateSystem::~CoordinateSystem() [" << this << "]");
@@ -181,14 +346,45 @@ class CoordinateSystem
         plot_area_.geometry().offset_y() + 0.5 * plot_area_.geometry().height(), ylabel_style)) { }
 #endif
 
+ private:
+  // Only called by update_axes: the ranges follow from the transform. It doesn't call layout() itself,
+  // because the callers of update_axes (the constructor and set_transform) do that afterwards.
   void set_range(int axis, Range<cs> range)
   {
-    DoutEntering(dc::notice, "CoordinateSystem::set_range(" << axis << ", " << range << ") [" << this << "]");
+    TRACE_OR_DOUT((trace::Event::set_range, axis, range.min(), range.max(), this),
+        DoutEntering(dc::notice, "CoordinateSystem::set_range(" << axis << ", " << range << ") [" << this << "]"));
+    if (range.min() == range_[axis].min() && range.max() == range_[axis].max())
+      return;
     range_[axis] = range;
-    range_ticks_[axis] = NiceDelta<cs>{range};
-    Dout(dc::notice, "range_[" << axis << "] = " << range_[axis] << "; range_ticks_[" << axis << "] = " << range_ticks_[axis]);
+    TickHierarchy<cs> const ticks = [&range]{
+      PROFILE_SCOPE(profiler::Phase::nice_delta);
+      return TickHierarchy<cs>{range};
+    }();
+    // Keep the cached labels of tick levels whose spacing didn't change, even if that spacing moved to a different level.
+    auto const stable_ticks = ticks.stable_ticks(ticks_[axis]);
+    std::array<LabelCache, number_of_tick_levels> label_cache;
+    for (int level = 0; level < number_of_tick_levels; ++level)
+    {
+      int const previous_level = stable_ticks[level].previous_level;
+      if (previous_level != -1)
+      {
+        // Only the labels of ticks that exist in both the old and the new range are still valid.
+        label_cache[level] = std::move(label_cache_[axis][previous_level]);
+        label_cache[level].trim(stable_ticks[level].k_min, stable_ticks[level].k_max);
+        TRACE_OR_DOUT((trace::Event::reuse_tick_level, level, previous_level, stable_ticks[level].k_min, stable_ticks[level].k_max),
+            Dout(dc::notice, "Level " << level << " reuses level " << previous_level << "; ticks [" <<
+                stable_ticks[level].k_min << ", " << stable_ticks[level].k_max << "] are unchanged."));
+      }
+    }
+    label_cache_[axis] = std::move(label_cache);
+    ticks_[axis] = ticks;
+    TRACE_OR_DOUT((trace::Event::range_ticks, axis, range.min(), range.max(),
+          ticks.level(TickHierarchy<cs>::major).value(), ticks.level(TickHierarchy<cs>::major).m()),
+        Dout(dc::notice, "range_[" << axis << "] = " << range_[axis] << "; ticks_[" << axis << "] major = " <<
+            ticks_[axis].level(TickHierarchy<cs>::major)));
   }
 
+ public:
   cwin::Point clamp_to_plot_area(cwin::Point const& point) const
   {
     return {std::clamp(point.x(), range_[x_axis].min(), range_[x_axis].max()),
@@ -203,6 +399,14 @@ class CoordinateSystem
     return {range_[x_axis].min(), range_[y_axis].min(), range_[x_axis].size(), range_[y_axis].size()};
   }
 
+  // Map lines to pixels and clip them against the window, in one pass. The visible pieces replace the contents of pieces.
+  // No draw objects are created; use this for large numbers of lines (grid lines, reference lines), instead of add_line.
+  // Returns the number of visible pieces.
+  std::size_t clip_lines(LineArray<cs> const& lines, LinePieceArray<CS::pixels>& pieces) const
+  {
+    return clipper::clip_and_map(lines, cs_transform_pixels_, Rectangle<CS::pixels>{0, 0, window_width, window_height}, pieces);
+  }
+
 #if 0
   double convert_x(double x) const;
   double convert_y(double y) const;
@@ -445,9 +649,50 @@ class CoordinateSystem
   }
 #endif
 
-  void display(LayerPtr const& layer);
+  // Draw the CoordinateSystem on layer. Subsequent calls (after set_transform) only replace the
+  // lines and labels that changed; therefore this must always be called with the same layer.
+  //
+  // Returns the region of the layer that must be repainted: the union of the bounding boxes of the
+  // lines and labels that were added or removed. This is empty if nothing changed since the last call.
+  DirtyRegion display(LayerPtr const& layer);
+
+  // Same as display, but don't touch the layer: add the draw objects that must be drawn, and those that
+  // must be removed, to batch. Different CoordinateSystem objects can be prepared concurrently; the batch
+  // must then be submitted to the layer (that display would have been called with) by the thread that owns it.
+  void prepare(DrawBatch& batch);
 
  private:
+  // Calculate tick_axis_, line_piece_ and the ranges from cs_transform_pixels_.
+  void update_axes();
+
+  // Calculate line_geometry_ and text_geometry_.
+  void layout();
+
+  // Return the (cached) label of tick k on axis.
+  std::string const& tick_label(int axis, int k);
+
+  // Return the smallest stride from 1, 2, 5, 10, 20, 50, ... that is a multiple of multiple_of and for which
+  // stride * spacing >= min_spacing.
+  static int lod_stride(double spacing, double min_spacing, int multiple_of);
+
+  // Call reuse(i, j) for every element i of geometry that is equal to element j of drawn_geometry,
+  // and create(i) for every other element. Both vectors must be sorted by key.
+  template<typename Geometry, typename Reuse, typename Create>
+  static void match_drawn_geometry(std::vector<Geometry> const& geometry, std::vector<Geometry> const& drawn_geometry,
+      Reuse reuse, Create create)
+  {
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < geometry.size(); ++i)
+    {
+      while (j < drawn_geometry.size() && drawn_geometry[j].key < geometry[i].key)
+        ++j;
+      if (j < drawn_geometry.size() && drawn_geometry[j] == geometry[i])
+        reuse(i, j);
+      else
+        create(i);
+    }
+  }
+
 //  void apply_line_extend(double& x1, double& y1, double& x2, double& y2, LineExtend line_extend);
 };
 
@@ -464,68 +709,77 @@ namespace detail {
 // The points are returned as a Point<cs>. The caller is responsible to
 // make sure that the rectangle uses that same coordinate system.
 template<CS cs>
-std::tuple<int, std::array<Point<cs>, 2>> intersect(Line<cs> line_cs, math::Hyperblock<2> rectangle_cs)
+std::tuple<int, std::array<Point<cs>, 2>> intersect(Line<cs> const& line_cs, Rectangle<cs> const& rectangle_cs)
 {
 //  DoutEntering(dc::notice, "detail::intersect(" << line_cs << ", " << rectangle_cs << ")");
 
-  double normal_x = -line_cs.direction().y();
-  double normal_y = line_cs.direction().x();
-  math::Hyperplane<2> line({normal_x, normal_y}, -(normal_x * line_cs.point().x() + normal_y* line_cs.point().y()));
-  auto intersections_cs = rectangle_cs.intersection_points(line);
-
-  // Is the line outside the window?
-  if (intersections_cs.empty())
-    return {};
-
-  ASSERT(intersections_cs.size() == 2);
-
-  // Return the two points where the line_cs intersects with the rectangle_cs.
-  return {
-    2, {
-      Point<cs>(intersections_cs[0][0], intersections_cs[0][1]),
-      Point<cs>(intersections_cs[1][0], intersections_cs[1][1])
-    }
-  };
+  std::array<Point<cs>, 2> intersections_cs;
+  int const number_of_intersection_points = clipper::clip(line_cs, rectangle_cs, intersections_cs);
+  return {number_of_intersection_points, intersections_cs};
 }
 
 } // namespace detail
 
 template<CS cs>
 CoordinateSystem<cs>::CoordinateSystem(Transform<cs, CS::pixels> const cs_transform_pixels, LineStyle axis_style) :
-  cs_transform_pixels_(cs_transform_pixels), axis_style_{axis_style}
+  cs_transform_pixels_(cs_transform_pixels), has_transform_(true), axis_style_{axis_style}
+{
+  TRACE_OR_DOUT((trace::Event::constructor, cs_transform_pixels.matrix().m11(), cs_transform_pixels.matrix().m12(),
+        cs_transform_pixels.matrix().m21(), cs_transform_pixels.matrix().m22(),
+        cs_transform_pixels.matrix().dx(), cs_transform_pixels.matrix().dy(), this),
+      DoutEntering(dc::notice, "CoordinateSystem::CoordinateSystem(" << cs_transform_pixels << ", axis_style) [" << this << "]"));
+  PROFILE_SCOPE(profiler::Phase::constructor);
+  update_axes();
+  layout();
+}
+
+template<CS cs>
+void CoordinateSystem<cs>::set_transform(Transform<cs, CS::pixels> const& cs_transform_pixels)
 {
-  DoutEntering(dc::notice, "CoordinateSystem::CoordinateSystem(" << cs_transform_pixels << ", axis_style) [" << this << "]");
+  TRACE_OR_DOUT((trace::Event::set_transform, cs_transform_pixels.matrix().m11(), cs_transform_pixels.matrix().m12(),
+        cs_transform_pixels.matrix().m21(), cs_transform_pixels.matrix().m22(),
+        cs_transform_pixels.matrix().dx(), cs_transform_pixels.matrix().dy(), this),
+      DoutEntering(dc::notice, "CoordinateSystem::set_transform(" << cs_transform_pixels << ") [" << this << "]"));
+  PROFILE_SCOPE(profiler::Phase::set_transform);
+
+  if (has_transform_ && cs_transform_pixels == cs_transform_pixels_)
+    return;
+
+  cs_transform_pixels_ = cs_transform_pixels;
+  has_transform_ = true;
+  update_axes();
+  layout();
+}
+
+template<CS cs>
+void CoordinateSystem<cs>::update_axes()
+{
+  PROFILE_SCOPE(profiler::Phase::update_axes);
 
   // Calculate where the cs-axis intersect with the window geometry.
 
-  // Construct three points on the CS axis.
-  Point<cs> csOrigin_cs;
-  Point<cs> csXAxisUnit_cs(1, 0);
-  Point<cs> csYAxisUnit_cs(0, 1);
-  // Convert them to pixel coordinates.
-  csOrigin_pixels_ = csOrigin_cs * cs_transform_pixels;
-  Point<CS::pixels> csXAxisUnit_pixels = csXAxisUnit_cs * cs_transform_pixels;
-  Point<CS::pixels> csYAxisUnit_pixels = csYAxisUnit_cs * cs_transform_pixels;
-  // Store the directions (in pixels coordinates).
-  csAxisDirection_[x_axis] = Direction(csOrigin_pixels_, csXAxisUnit_pixels);
-  csAxisDirection_[y_axis] = Direction(csOrigin_pixels_, csYAxisUnit_pixels);
+  // Calculate the origin and the direction of both axes (in pixels coordinates); these are used for all tick marks of an axis.
+  tick_axis_[x_axis] = TickAxis<cs>{x_axis, cs_transform_pixels_};
+  tick_axis_[y_axis] = TickAxis<cs>{y_axis, cs_transform_pixels_};
 
   // The inverse transform.
-  auto const& pixels_transform_cs = cs_transform_pixels.inverse();
+  auto const& pixels_transform_cs = cs_transform_pixels_.inverse();
 
   // Calcuate the length that is visible of each CS axis, in pixels.
   for (int axis = x_axis; axis <= y_axis; ++axis)
   {
     // Determine where the axis intersects with the window rectangle (everything in pixels).
     auto [number_of_intersection_points, intersection_point_pixels] = detail::intersect<CS::pixels>(
-        {csOrigin_pixels_, csAxisDirection_[axis]},     // The axis (pointing in the direction csAxisDirection_).
-        {{0, 0}, {window_width, window_height}});       // The window rectangle.
+        {tick_axis_[axis].origin, tick_axis_[axis].direction},  // The axis (pointing in the direction of the positive axis).
+        {0, 0, window_width, window_height});           // The window rectangle.
 
     // Is the line outside the window?
     if (number_of_intersection_points < 2)
     {
       cwin::Point const origin(0, 0);
       line_piece_[axis] = cwin::LinePiece{origin, origin};      // Use twice the same point to encode that this axis is not visible within the window.
+      range_[axis] = Range<cs>{0.0, 0.0};
+      ticks_[axis] = TickHierarchy<cs>{};
       continue;
     }
 
@@ -534,13 +788,15 @@ CoordinateSystem<cs>::CoordinateSystem(Transform<cs, CS::pixels> const cs_transf
     constexpr int to = 1;       // Same, but the positive side of the axis.
 
     line_piece_[axis] = cwin::LinePiece(intersection_point_pixels[from], intersection_point_pixels[to]);
-    Dout(dc::notice, "line_piece_[" << axis << "] = " << line_piece_[axis]);
+    TRACE_OR_DOUT((trace::Event::line_piece, axis, line_piece_[axis].from().x(), line_piece_[axis].from().y(),
+          line_piece_[axis].to().x(), line_piece_[axis].to().y()),
+        Dout(dc::notice, "line_piece_[" << axis << "] = " << line_piece_[axis]));
 
     // Convert the intersection points back to cs.
     Point<cs> const from_cs = intersection_point_pixels[from] * pixels_transform_cs;
     Point<cs> const   to_cs =   intersection_point_pixels[to] * pixels_transform_cs;
-    Dout(dc::notice, "from_cs = " << from_cs);
-    Dout(dc::notice, "to_cs = " << to_cs);
+    TRACE_OR_DOUT((trace::Event::axis_range_cs, from_cs.x(), from_cs.y(), to_cs.x(), to_cs.y()),
+        Dout(dc::notice, "from_cs = " << from_cs << "; to_cs = " << to_cs));
     // Extract the minimum and maximum values of the visible range.
     double min = (axis == x_axis) ? from_cs.x() : from_cs.y();
     double max = (axis == x_axis) ?   to_cs.x() :   to_cs.y();
@@ -551,87 +807,255 @@ CoordinateSystem<cs>::CoordinateSystem(Transform<cs, CS::pixels> const cs_transf
 }
 
 template<CS cs>
-void CoordinateSystem<cs>::display(LayerPtr const& layer)
+std::string const& CoordinateSystem<cs>::tick_label(int axis, int k)
+{
+  std::string& label = label_cache_[axis][TickHierarchy<cs>::major][k];
+  // A label is never empty, so an empty string means that it wasn't formatted yet.
+  if (label.empty())
+  {
+    PROFILE_SCOPE(profiler::Phase::label_formatting);
+    PROFILE_COUNT(profiler::Counter::labels_formatted, 1);
+    label = ticks_[axis].level(TickHierarchy<cs>::major).fixed_capacity_label(k).view();
+  }
+  return label;
+}
+
+template<CS cs>
+int CoordinateSystem<cs>::lod_stride(double spacing, double min_spacing, int multiple_of)
 {
-  DoutEntering(dc::notice, "CoordinateSystem<" << utils::to_string(cs) << ">::display(layer)");
+  static constexpr std::array<int, 3> mantissa = { 1, 2, 5 };
+  for (int power = 1; power <= 100000000; power *= 10)
+    for (int m : mantissa)
+    {
+      int const stride = m * power;
+      if (stride % multiple_of == 0 && stride * spacing >= min_spacing)
+        return stride;
+    }
+  // The spacing is (nearly) zero: return a stride that is larger than any k, so that no tick is drawn.
+  return 1000000000;
+}
+
+template<CS cs>
+void CoordinateSystem<cs>::layout()
+{
+  PROFILE_SCOPE(profiler::Phase::layout);
+  needs_display_ = true;
+
+  // Reuse the storage of the previous layout.
+  line_geometry_.clear();
+  text_geometry_.clear();
+
+  // Each visible axis has one line for the axis itself, plus at most m() tick marks per drawn level and m() major labels.
+  std::size_t max_lines = 0;
+  std::size_t max_texts = 0;
+  for (int axis = x_axis; axis <= y_axis; ++axis)
+  {
+    if (range_[axis].size() == 0.0)
+      continue;
+    ++max_lines;
+    if (!ticks_[axis].is_invalid())
+    {
+      for (int level = 0; level < tick_levels_; ++level)
+        max_lines += ticks_[axis].level(level).m();
+      max_texts += ticks_[axis].level(TickHierarchy<cs>::major).m();
+    }
+  }
+  line_geometry_.reserve(max_lines);
+  text_geometry_.reserve(max_texts);
 
-  ASSERT(texts_.empty());
   for (int axis = x_axis; axis <= y_axis; ++axis)
   {
     // If the range is empty then min = max = 0 and size() will return zero exactly.
     if (range_[axis].size() == 0.0)     // Not visible?
       continue;
     // Draw the piece of the axis that is visible.
-    lines_.emplace_back(std::make_shared<cwin::draw::Line>(
-          line_piece_[axis].from().x(), line_piece_[axis].from().y(),
-          line_piece_[axis].to().x(), line_piece_[axis].to().y(),
-          axis_style_));
-    layer->draw(lines_.back());
+    line_geometry_.push_back({{axis, axis_line_level, 0},
+        {line_piece_[axis].from().x(), line_piece_[axis].from().y()},
+        {line_piece_[axis].to().x(), line_piece_[axis].to().y()}});
 
-    if (range_ticks_[axis].is_invalid())
+    if (ticks_[axis].is_invalid())
       continue;
 
-    // Draw the tick marks.
-    double const delta_cs = range_ticks_[axis].value();
-    int k_min = std::ceil(range_[axis].min() / delta_cs);
-    int k_max = std::floor(range_[axis].max() / delta_cs);
-    auto const axis_direction = csAxisDirection_[axis];
-    bool const axis_prefers_parallel = std::abs(axis_direction.x()) >= std::abs(axis_direction.y());
-    auto const axis_angle = axis_direction.as_angle();
+    // Draw the tick marks; ticks of finer levels are shorter and don't have a label.
+    static constexpr std::array<double, number_of_tick_levels> tick_length = { 5.0, 3.0, 2.0 };
+    static constexpr double label_distance = 10.0;
+
+    // The position and rotation of the labels are the same for all ticks of an axis.
+    TickAxis<cs> const& tick_axis = tick_axis_[axis];
     double const pi = std::acos(-1.0);
-    auto normalize_readable = [pi](double angle) {
-      if (angle > 0.5 * pi)
-        angle -= pi;
-      else if (angle <= -0.5 * pi)
-        angle += pi;
-      return angle;
-    };
-    for (int k = k_min; k <= k_max; ++k)
+    double rotation = tick_axis.direction.as_angle();
+    cwin::draw::TextPosition position;
+    if (std::abs(tick_axis.direction.x()) >= std::abs(tick_axis.direction.y()))
+      position = tick_axis.tick_direction.y() < 0 ? cwin::draw::centered_above : cwin::draw::centered_below;
+    else
     {
-      if (k == 0)
-        continue;
-      double value_cs = k * delta_cs;
-      Point<cs> tick_cs{axis == x_axis ? value_cs : 0.0, axis == y_axis ? value_cs : 0.0};
-      Point<CS::pixels> tick_pixels = tick_cs * cs_transform_pixels_;
-      // Unit vector pointing into the positive direction of axis.
-      Direction axis_pixels{csOrigin_pixels_, tick_pixels};
-      Direction axis_tickmark_pixels = (axis == x_axis) == (k < 0) ? axis_pixels.normal() : axis_pixels.normal_inverse();
-      Point<CS::pixels> tick_end_pixels = tick_pixels + Vector<CS::pixels>{axis_tickmark_pixels, 5.0};
-      lines_.emplace_back(std::make_shared<cwin::draw::Line>(
-            tick_pixels.x(), tick_pixels.y(),
-            tick_end_pixels.x(), tick_end_pixels.y(),
-            axis_style_));
-      layer->draw(lines_.back());
-
-      Point<CS::pixels> text_anchor_pixels = tick_pixels + Vector<CS::pixels>{axis_tickmark_pixels, 10.0};
-
-      std::string label = range_ticks_[axis].label(k);
-
-      double rotation = axis_angle;
-      cwin::draw::TextPosition position;
-      if (axis_prefers_parallel)
-        position = axis_tickmark_pixels.y() < 0 ? cwin::draw::centered_above : cwin::draw::centered_below;
-      else
+      rotation += 0.5 * pi;
+      position = tick_axis.tick_direction.x() < 0 ? cwin::draw::centered_left_of : cwin::draw::centered_right_of;
+    }
+    // Keep the text readable (not upside down).
+    if (rotation > 0.5 * pi)
+      rotation -= pi;
+    else if (rotation <= -0.5 * pi)
+      rotation += pi;
+
+    // Decide, from the scale of the transform alone, which ticks and labels are drawn.
+    double const pixels_per_unit = std::sqrt(tick_axis.unit.x() * tick_axis.unit.x() + tick_axis.unit.y() * tick_axis.unit.y());
+    NiceDelta<cs> const& major_delta = ticks_[axis].level(TickHierarchy<cs>::major);
+    double const major_spacing = major_delta.value() * pixels_per_unit;
+    int const tick_stride = lod_stride(major_spacing, min_tick_spacing, 1);
+    // The widest label is normally that of the first or last tick (the largest magnitude, or a minus sign).
+    std::size_t const label_length = std::max(major_delta.fixed_capacity_label(ticks_[axis].k_min(TickHierarchy<cs>::major)).view().size(),
+                                              major_delta.fixed_capacity_label(ticks_[axis].k_max(TickHierarchy<cs>::major)).view().size());
+    // Parallel labels are rotated along the axis, the others are perpendicular to it.
+    double const label_extent = position == cwin::draw::centered_above || position == cwin::draw::centered_below ?
+        label_length * label_char_width : label_height;
+    int const label_stride = lod_stride(major_spacing, label_extent + label_padding, tick_stride);
+    if (label_stride > 1)
+      TRACE_OR_DOUT((trace::Event::label_stride, axis, major_spacing, tick_stride, label_stride),
+          Dout(dc::notice, "Axis " << axis << ": major tick spacing is " << major_spacing << " pixels; drawing every " <<
+              tick_stride << "th tick and every " << label_stride << "th label."));
+
+    for (int level = 0; level < tick_levels_; ++level)
+    {
+      // Finer levels are dropped altogether when they are too dense; the levels after them are even denser.
+      if (level != TickHierarchy<cs>::major && ticks_[axis].level(level).value() * pixels_per_unit < min_tick_spacing)
+      {
+        TRACE_OR_DOUT((trace::Event::dropped_tick_levels, axis, level),
+            Dout(dc::notice, "Axis " << axis << ": not drawing tick levels " << level << " and up."));
+        break;
+      }
+      for (Tick<cs> const& tick : TickRange<cs>{ticks_[axis], level, tick_axis, tick_length[level], label_distance,
+          level == TickHierarchy<cs>::major ? tick_stride : 1})
       {
-        rotation += 0.5 * pi;
-        position = axis_tickmark_pixels.x() < 0 ? cwin::draw::centered_left_of : cwin::draw::centered_right_of;
+        line_geometry_.push_back({{axis, level, tick.k}, tick.position, tick.end});
+        if (level == TickHierarchy<cs>::major && tick.k % label_stride == 0)
+          text_geometry_.push_back({{axis, level, tick.k}, tick_label(axis, tick.k), tick.label_anchor, position, rotation});
       }
-      rotation = normalize_readable(rotation);
+    }
+  }
+}
 
-      cwin::draw::TextStyle text_style({
-          .position = position,
-          .color = axis_style_.line_color(),
-          .rotation = rotation
-      });
+template<CS cs>
+DirtyRegion CoordinateSystem<cs>::display(LayerPtr const& layer)
+{
+  TRACE_OR_DOUT((trace::Event::display, this),
+      DoutEntering(dc::notice, "CoordinateSystem<" << utils::to_string(cs) << ">::display(layer)"));
+  PROFILE_SCOPE(profiler::Phase::display);
+
+  // Neither the transform, nor the ranges or the number of tick levels changed: nothing to do.
+  if (!needs_display_)
+    return {};
 
-      texts_.emplace_back(std::make_shared<cwin::draw::Text>(
-            label,
-            text_anchor_pixels.x(),
-            text_anchor_pixels.y(),
-            text_style));
-      layer->draw(texts_.back());
+  DrawBatch batch;
+  prepare(batch);
+  batch.submit(layer);
+  return batch.dirty_region;
+}
+
+template<CS cs>
+void CoordinateSystem<cs>::prepare(DrawBatch& batch)
+{
+  ASSERT(has_transform_);
+  PROFILE_SCOPE(profiler::Phase::prepare);
+
+  if (!needs_display_)
+    return;
+  needs_display_ = false;
+
+  DirtyRegion& dirty_region = batch.dirty_region;
+
+  // Only create draw objects for geometry that changed since the previous call. A line or label with the same key
+  // and geometry as before keeps its draw object, even when ticks before it were added or removed.
+  // A cairowindow draw::Line or draw::Text can not be changed after it was created (its geometry and style are
+  // only passed to its constructor), therefore an object whose geometry changed is replaced by a new one instead
+  // of being updated in place. During a rotation that is every tick of every frame.
+  auto const no_op = [](std::size_t, std::size_t){ };
+
+  // Allocate all new objects of this pass from one arena, sized for exactly the objects that will be created.
+  // Objects that are reused by later passes keep the arena of their pass alive (see DrawObjectArena). The axis
+  // lines are the only objects that typically survive many passes, therefore they are allocated from the heap.
+  std::shared_ptr<DrawObjectArena> arena;
+  if (allocation_mode_ == AllocationMode::arena)
+  {
+    std::size_t number_of_new_lines = 0;
+    match_drawn_geometry(line_geometry_, drawn_line_geometry_, no_op,
+        [&](std::size_t i){ number_of_new_lines += line_geometry_[i].key.level != axis_line_level; });
+    std::size_t number_of_new_texts = 0;
+    match_drawn_geometry(text_geometry_, drawn_text_geometry_, no_op, [&](std::size_t){ ++number_of_new_texts; });
+    if (number_of_new_lines + number_of_new_texts > 0)
+    {
+      std::size_t const arena_size = DrawObjectArena::size_for<cwin::draw::Line>(number_of_new_lines) +
+                                     DrawObjectArena::size_for<cwin::draw::Text>(number_of_new_texts);
+      PROFILE_COUNT(profiler::Counter::arena_bytes, arena_size);
+      arena = std::make_shared<DrawObjectArena>(arena_size);
     }
   }
+
+  // Move the draw objects of the previous call to previous_lines_ and previous_texts_. Those that are not
+  // reused are moved to the retired objects of the batch.
+  lines_.swap(previous_lines_);
+  lines_.clear();
+  lines_.resize(line_geometry_.size());
+  match_drawn_geometry(line_geometry_, drawn_line_geometry_,
+      [this](std::size_t i, std::size_t j){
+        lines_[i] = std::move(previous_lines_[j]);
+        PROFILE_COUNT(profiler::Counter::lines_reused, 1);
+      },
+      [&](std::size_t i){
+        LineGeometry const& line = line_geometry_[i];
+        {
+          PROFILE_SCOPE(profiler::Phase::allocation);
+          std::shared_ptr<DrawObjectArena> const& line_arena = line.key.level == axis_line_level ? nullptr : arena;
+          lines_[i] = allocate_draw_object<cwin::draw::Line>(line_arena, line.from.x(), line.from.y(), line.to.x(), line.to.y(), axis_style_);
+        }
+        PROFILE_COUNT(profiler::Counter::lines_allocated, 1);
+        batch.lines.push_back(lines_[i]);
+        line.add_to(dirty_region, axis_style_.line_width());
+      });
+  // The lines that were not moved to lines_ must be removed from the layer.
+  for (std::size_t j = 0; j < previous_lines_.size(); ++j)
+    if (previous_lines_[j])
+    {
+      drawn_line_geometry_[j].add_to(dirty_region, axis_style_.line_width());
+      batch.retired_lines.push_back(std::move(previous_lines_[j]));
+    }
+  previous_lines_.clear();
+  drawn_line_geometry_ = line_geometry_;
+
+  texts_.swap(previous_texts_);
+  texts_.clear();
+  texts_.resize(text_geometry_.size());
+  match_drawn_geometry(text_geometry_, drawn_text_geometry_,
+      [this](std::size_t i, std::size_t j){
+        texts_[i] = std::move(previous_texts_[j]);
+        PROFILE_COUNT(profiler::Counter::texts_reused, 1);
+      },
+      [&](std::size_t i){
+        TextGeometry const& text = text_geometry_[i];
+        cwin::draw::TextStyle text_style({
+            .position = text.position,
+            .color = axis_style_.line_color(),
+            .rotation = text.rotation
+        });
+        {
+          PROFILE_SCOPE(profiler::Phase::allocation);
+          texts_[i] = allocate_draw_object<cwin::draw::Text>(arena, text.label, text.anchor.x(), text.anchor.y(), text_style);
+        }
+        PROFILE_COUNT(profiler::Counter::texts_allocated, 1);
+        batch.texts.push_back(texts_[i]);
+        text.add_to(dirty_region);
+      });
+  for (std::size_t j = 0; j < previous_texts_.size(); ++j)
+    if (previous_texts_[j])
+    {
+      drawn_text_geometry_[j].add_to(dirty_region);
+      batch.retired_texts.push_back(std::move(previous_texts_[j]));
+    }
+  previous_texts_.clear();
+  drawn_text_geometry_ = text_geometry_;
+
+  TRACE_OR_DOUT((trace::Event::dirty_region, dirty_region.min_x(), dirty_region.min_y(), dirty_region.max_x(), dirty_region.max_y()),
+      Dout(dc::notice, "dirty_region = " << dirty_region));
 }
 
 //FIXME: add_* doesn't work like this: need to pass an object (eg plot::Point<cs>) derived from Point<cs> that also stores a std::shared_ptr<Point<pixels>.
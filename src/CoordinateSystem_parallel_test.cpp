@@ -0,0 +1,162 @@
+#include "sys.h"
+#include "CoordinateSystem.h"
+#include "DrawBatch.h"
+#include "MPSCQueue.h"
+#include "Stopwatch.h"
+#include "Transform.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "debug.h"
+
+// Build and lay out many CoordinateSystem objects in worker threads, hand their draw batches to
+// one consumer thread through an MPSCQueue, and check that every batch is the same as when
+// everything runs sequentially.
+//
+// Usage: CoordinateSystem_parallel_test [number_of_systems [number_of_threads]]
+
+namespace {
+
+constexpr int number_of_frames = 24;    // The angle sweep of draw_coordinates: 0, 15, ..., 345 degrees.
+
+using CoordinateSystem = draw::CoordinateSystem<CS::painter>;
+
+// The transform of system s in frame f.
+Transform<CS::painter, CS::pixels> painter_transform_pixels(int s, int f)
+{
+  constexpr Transform<CS::centered, CS::pixels> centered_transform_pixels =
+    Transform<CS::centered, CS::pixels>{}.translate(half_window_size).scale(half_window_size.height());
+  auto const painter_transform_centered = Transform<CS::painter, CS::centered>{}
+    .translate(TranslationVector{Size<CS::centered>{0.01 * (s % 10), -0.01 * (s % 7)}}).scale(1.0 + 0.25 * (s % 5)).rotate(15.0 * f + s);
+  return painter_transform_centered * centered_transform_pixels;
+}
+
+std::unique_ptr<CoordinateSystem> create_system(int s)
+{
+  namespace color = cairowindow::color;
+  auto system = std::make_unique<CoordinateSystem>(painter_transform_pixels(s, 0),
+      cairowindow::draw::LineStyle({.line_color = color::red, .line_width = 1.0}));
+  // Also exercise the minor tick levels.
+  system->set_tick_levels(1 + s % 3);
+  return system;
+}
+
+// What a batch contained, for comparison.
+struct Summary
+{
+  std::size_t lines;
+  std::size_t texts;
+  std::size_t retired_lines;
+  std::size_t retired_texts;
+  double min_x;
+  double min_y;
+  double max_x;
+  double max_y;
+
+  explicit Summary(DrawBatch const& batch) :
+    lines(batch.lines.size()), texts(batch.texts.size()),
+    retired_lines(batch.retired_lines.size()), retired_texts(batch.retired_texts.size()),
+    min_x(batch.dirty_region.min_x()), min_y(batch.dirty_region.min_y()),
+    max_x(batch.dirty_region.max_x()), max_y(batch.dirty_region.max_y()) { }
+
+  Summary() = default;
+  friend bool operator==(Summary const& lhs, Summary const& rhs) = default;
+};
+
+// A batch, plus where it came from.
+struct FrameBatch
+{
+  int frame;
+  int system;
+  DrawBatch batch;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  int const number_of_systems = argc > 1 ? std::stoi(argv[1]) : 256;
+  unsigned int const number_of_threads = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+  // The reference: everything in this thread.
+  std::vector<Summary> expected(number_of_frames * number_of_systems);
+  Stopwatch sequential;
+  sequential.start();
+  {
+    std::vector<std::unique_ptr<CoordinateSystem>> systems;
+    for (int s = 0; s < number_of_systems; ++s)
+      systems.push_back(create_system(s));
+    for (int f = 0; f < number_of_frames; ++f)
+      for (int s = 0; s < number_of_systems; ++s)
+      {
+        if (f > 0)
+          systems[s]->set_transform(painter_transform_pixels(s, f));
+        DrawBatch batch;
+        systems[s]->prepare(batch);
+        expected[f * number_of_systems + s] = Summary{batch};
+      }
+  }
+  sequential.stop();
+
+  // The same, with each worker thread owning a subset of the systems.
+  MPSCQueue<FrameBatch> queue;
+  Stopwatch parallel;
+  parallel.start();
+  std::vector<std::thread> workers;
+  for (unsigned int w = 0; w < number_of_threads; ++w)
+    workers.emplace_back([&queue, w, number_of_threads, number_of_systems](){
+      std::vector<std::unique_ptr<CoordinateSystem>> systems;
+      for (int s = w; s < number_of_systems; s += number_of_threads)
+        systems.push_back(create_system(s));
+      for (int f = 0; f < number_of_frames; ++f)
+        for (std::size_t i = 0; i < systems.size(); ++i)
+        {
+          int const s = w + i * number_of_threads;
+          if (f > 0)
+            systems[i]->set_transform(painter_transform_pixels(s, f));
+          FrameBatch frame_batch{f, s, {}};
+          systems[i]->prepare(frame_batch.batch);
+          queue.push(std::move(frame_batch));
+        }
+      // The systems are destroyed here, but the draw objects that the consumer received stay alive until it releases them.
+    });
+
+  // The consumer: plays the role of the thread that owns the layer, and drains the queue once per "frame".
+  int const total = number_of_frames * number_of_systems;
+  int received = 0;
+  int drains = 0;
+  int mismatches = 0;
+  while (received < total)
+  {
+    std::size_t const count = queue.drain([&](FrameBatch&& frame_batch){
+      if (!(Summary{frame_batch.batch} == expected[frame_batch.frame * number_of_systems + frame_batch.system]))
+      {
+        std::cerr << "Mismatch for system " << frame_batch.system << " in frame " << frame_batch.frame << std::endl;
+        ++mismatches;
+      }
+      // Here the batch would be submitted to the layer; this releases the retired draw objects.
+    });
+    received += count;
+    if (count > 0)
+      ++drains;
+    else
+      std::this_thread::sleep_for(std::chrono::microseconds(250));      // Wait for the next "frame".
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+  parallel.stop();
+
+  std::cout << number_of_systems << " systems, " << number_of_frames << " frames, " << number_of_threads << " threads: " <<
+    received << " batches received in " << drains << " drains; " << mismatches << " mismatches." << std::endl;
+  std::cout << "sequential: " << sequential.elapsed_seconds() * 1e3 << " ms; parallel: " << parallel.elapsed_seconds() * 1e3 <<
+    " ms (" << sequential.elapsed_seconds() / parallel.elapsed_seconds() << "x)." << std::endl;
+
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
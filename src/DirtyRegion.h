@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Point.h"
+#include "Rectangle.h"
+#include "utils/has_print_on.h"
+#include <algorithm>
+#include <limits>
+
+using utils::has_print_on::operator<<;
+
+// The axis-aligned bounding box (in CS::pixels) of everything that changed on a layer.
+//
+// A default constructed DirtyRegion is empty: nothing needs to be repainted.
+class DirtyRegion
+{
+ private:
+  double min_x_ = std::numeric_limits<double>::infinity();
+  double min_y_ = std::numeric_limits<double>::infinity();
+  double max_x_ = -std::numeric_limits<double>::infinity();
+  double max_y_ = -std::numeric_limits<double>::infinity();
+
+ public:
+  bool is_empty() const { return min_x_ > max_x_; }
+
+  // The bounds of the region; when the region is empty, the minimums are +inf and the maximums -inf.
+  double min_x() const { return min_x_; }
+  double min_y() const { return min_y_; }
+  double max_x() const { return max_x_; }
+  double max_y() const { return max_y_; }
+
+  // Grow the region to include the square with half-size margin around point.
+  void add(Point<CS::pixels> const& point, double margin = 0.0)
+  {
+    min_x_ = std::min(min_x_, point.x() - margin);
+    min_y_ = std::min(min_y_, point.y() - margin);
+    max_x_ = std::max(max_x_, point.x() + margin);
+    max_y_ = std::max(max_y_, point.y() + margin);
+  }
+
+  // Grow the region to include region.
+  void add(DirtyRegion const& region)
+  {
+    min_x_ = std::min(min_x_, region.min_x_);
+    min_y_ = std::min(min_y_, region.min_y_);
+    max_x_ = std::max(max_x_, region.max_x_);
+    max_y_ = std::max(max_y_, region.max_y_);
+  }
+
+  // Return the region as a rectangle. The region may not be empty.
+  Rectangle<CS::pixels> rectangle() const
+  {
+    return {min_x_, min_y_, max_x_ - min_x_, max_y_ - min_y_};
+  }
+
+  void print_on(std::ostream& os) const
+  {
+    if (is_empty())
+      os << "{<empty>}";
+    else
+      os << "{(" << min_x_ << ", " << min_y_ << ") - (" << max_x_ << ", " << max_y_ << ")}";
+  }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "DirtyRegion.h"
+#include "Profiler.h"
+#include "cairowindow/draw/Line.h"
+#include "cairowindow/draw/Text.h"
+#include "cairowindow/Layer.h"
+#include <boost/intrusive_ptr.hpp>
+#include <memory>
+#include <vector>
+
+// The draw objects that one CoordinateSystem::prepare pass created or retired.
+//
+// prepare only allocates; it never touches a Layer. Therefore it can run in any thread, after which
+// the batch is handed to the thread that owns the layer (for example through an MPSCQueue) and submitted there.
+struct DrawBatch
+{
+  std::vector<std::shared_ptr<cairowindow::draw::Line>> lines;          // Lines that must be drawn.
+  std::vector<std::shared_ptr<cairowindow::draw::Text>> texts;          // Labels that must be drawn.
+  std::vector<std::shared_ptr<cairowindow::draw::Line>> retired_lines;  // Lines that are no longer part of the drawing.
+  std::vector<std::shared_ptr<cairowindow::draw::Text>> retired_texts;  // Labels that are no longer part of the drawing.
+  DirtyRegion dirty_region;                                             // The union of the bounding boxes of all of the above.
+
+  bool empty() const { return lines.empty() && texts.empty() && retired_lines.empty() && retired_texts.empty(); }
+
+  // Draw the new objects on layer and release the retired ones (which removes them from the layer,
+  // unless something else still holds on to them).
+  void submit(boost::intrusive_ptr<cairowindow::Layer> const& layer)
+  {
+    for (auto const& line : lines)
+    {
+      PROFILE_SCOPE(profiler::Phase::layer_draw);
+      layer->draw(line);
+    }
+    for (auto const& text : texts)
+    {
+      PROFILE_SCOPE(profiler::Phase::layer_draw);
+      layer->draw(text);
+    }
+    retired_lines.clear();
+    retired_texts.clear();
+  }
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+// A monotonic arena from which the draw objects of a single display pass are allocated.
+//
+// Allocating from the arena is a pointer bump, and deallocating is a no-op; the memory of the
+// whole arena is released at once when the last object that was allocated from it is destroyed
+// (every ArenaAllocator, including the copy stored in each shared_ptr control block, keeps the
+// arena alive).
+//
+// Because draw objects whose geometry didn't change are reused by later passes, the objects of a
+// pass are not necessarily freed together: a single surviving object keeps the whole arena of its
+// pass alive, including the memory of all objects of that pass that were retired since. Objects that
+// are expected to live much longer than the others should therefore be allocated from the heap.
+class DrawObjectArena
+{
+ public:
+  // The size of the control block that std::allocate_shared adds to each object is implementation defined;
+  // this is a generous estimate that includes the copy of the ArenaAllocator that it stores.
+  static constexpr std::size_t control_block_size_estimate = 64;
+
+  // Return the arena size needed for `count` objects of type T.
+  template<typename T>
+  static constexpr std::size_t size_for(std::size_t count)
+  {
+    return count * (sizeof(T) + control_block_size_estimate);
+  }
+
+ private:
+  std::pmr::monotonic_buffer_resource resource_;
+
+ public:
+  // Construct an arena whose first block (allocated upon first use) has initial_size bytes.
+  explicit DrawObjectArena(std::size_t initial_size) : resource_(initial_size) { }
+
+  void* allocate(std::size_t bytes, std::size_t alignment) { return resource_.allocate(bytes, alignment); }
+};
+
+template<typename T>
+class ArenaAllocator
+{
+ private:
+  template<typename U>
+  friend class ArenaAllocator;
+
+  std::shared_ptr<DrawObjectArena> arena_;
+
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(std::shared_ptr<DrawObjectArena> arena) : arena_(std::move(arena)) { }
+
+  template<typename U>
+  ArenaAllocator(ArenaAllocator<U> const& other) : arena_(other.arena_) { }
+
+  T* allocate(std::size_t n)
+  {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T*, std::size_t) noexcept
+  {
+    // Memory is released when the arena is destroyed.
+  }
+
+  friend bool operator==(ArenaAllocator const& lhs, ArenaAllocator const& rhs) = default;
+};
+
+// Create a T from args, using the arena if there is one, and the heap otherwise.
+template<typename T, typename... Args>
+std::shared_ptr<T> allocate_draw_object(std::shared_ptr<DrawObjectArena> const& arena, Args&&... args)
+{
+  if (arena)
+    return std::allocate_shared<T>(ArenaAllocator<T>{arena}, std::forward<Args>(args)...);
+  return std::make_shared<T>(std::forward<Args>(args)...);
+}
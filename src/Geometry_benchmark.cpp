@@ -0,0 +1,133 @@
+#include "sys.h"
+#include "Vector.h"
+#include "Stopwatch.h"
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "debug.h"
+
+// Bulk geometry throughput of Point<cs> and Vector<cs>, compared to the way these wrappers used to be
+// implemented: derived from cairowindow::Point and cairowindow::Vector, with a user-declared copy
+// constructor and converting constructors that copy the base class of every forwarded result.
+
+namespace legacy {
+
+template<CS cs>
+class Point : public cairowindow::Point
+{
+ public:
+  Point() : cairowindow::Point(0.0, 0.0) { }
+  Point(double x, double y) : cairowindow::Point(x, y) { }
+  Point(cairowindow::Point&& base) : cairowindow::Point(base) { }
+};
+
+template<CS cs>
+class Vector : public cairowindow::Vector
+{
+ private:
+  Vector(cairowindow::Vector&& base) : cairowindow::Vector(base) { }
+
+ public:
+  Vector() = default;
+  Vector(Vector const& orig) : cairowindow::Vector(orig) { }
+  Vector(double x, double y) : cairowindow::Vector(x, y) { }
+
+  double dot(Vector const& v2) const { return cairowindow::Vector::dot(v2); }
+  Vector rotate_90_degrees() const { return cairowindow::Vector::rotate_90_degrees(); }
+};
+
+template<CS cs>
+inline Point<cs> operator+(Point<cs> const& point, Vector<cs> const& v2)
+{
+  return math::operator+(point, v2);
+}
+
+} // namespace legacy
+
+static_assert(!std::is_trivially_copyable_v<legacy::Vector<CS::pixels>>);
+static_assert(std::is_trivially_copyable_v<Vector<CS::pixels>>);
+
+namespace {
+
+struct Timings
+{
+  Stopwatch copy;
+  Stopwatch translate;
+  Stopwatch dot;
+};
+
+// Run the same three loops over either the current or the legacy types.
+template<template<CS> class PointType, template<CS> class VectorType>
+void run(std::vector<PointType<CS::pixels>> const& points, std::vector<VectorType<CS::pixels>> const& vectors, Timings& timings)
+{
+  std::size_t const n = points.size();
+  std::vector<VectorType<CS::pixels>> vectors_copy(n);
+  std::vector<PointType<CS::pixels>> translated(n);
+
+  // Copying an array; a memcpy for trivially copyable types.
+  timings.copy.start();
+  std::copy(vectors.begin(), vectors.end(), vectors_copy.begin());
+  timings.copy.stop();
+  do_not_optimize(vectors_copy.back());
+
+  // Point + rotated vector: two forwarded operations per element.
+  timings.translate.start();
+  for (std::size_t i = 0; i < n; ++i)
+    translated[i] = points[i] + vectors[i].rotate_90_degrees();
+  timings.translate.stop();
+  do_not_optimize(translated.back());
+
+  // A reduction.
+  timings.dot.start();
+  double sum = 0.0;
+  for (std::size_t i = 0; i < n; ++i)
+    sum += vectors[i].dot(vectors_copy[i]);
+  timings.dot.stop();
+  do_not_optimize(sum);
+}
+
+} // namespace
+
+int main()
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  constexpr int number_of_points = 10000;        // Small enough to stay in the cache.
+  constexpr int repeat = 1000;
+
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  std::vector<Point<CS::pixels>> points;
+  std::vector<Vector<CS::pixels>> vectors;
+  std::vector<legacy::Point<CS::pixels>> legacy_points;
+  std::vector<legacy::Vector<CS::pixels>> legacy_vectors;
+  for (int i = 0; i < number_of_points; ++i)
+  {
+    double const px = distribution(engine);
+    double const py = distribution(engine);
+    double const vx = distribution(engine);
+    double const vy = distribution(engine);
+    points.emplace_back(px, py);
+    vectors.emplace_back(vx, vy);
+    legacy_points.emplace_back(px, py);
+    legacy_vectors.emplace_back(vx, vy);
+  }
+
+  Timings before;
+  Timings after;
+  for (int r = 0; r < repeat; ++r)
+  {
+    run<legacy::Point, legacy::Vector>(legacy_points, legacy_vectors, before);
+    run<Point, Vector>(points, vectors, after);
+  }
+
+  uint64_t const total = uint64_t{number_of_points} * repeat;
+  std::cout << "                   before      after (ns/element)\n";
+  std::cout << "Copy:          " << std::setw(10) << before.copy.ns_per(total) << " " << std::setw(10) << after.copy.ns_per(total) << '\n';
+  std::cout << "Point + Vector:" << std::setw(10) << before.translate.ns_per(total) << " " << std::setw(10) << after.translate.ns_per(total) << '\n';
+  std::cout << "Dot product:   " << std::setw(10) << before.dot.ns_per(total) << " " << std::setw(10) << after.dot.ns_per(total) << '\n';
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+#include "debug.h"
+
+// The Gray code that is visited at step k.
+constexpr uint64_t gray_code(uint64_t k)
+{
+  return k ^ (k >> 1);
+}
+
+// Visit all n-bit words in (reflected binary) Gray code order, starting at zero.
+// Consecutive words differ in exactly one bit: step k flips bit std::countr_zero(k).
+template <typename F>
+void visit_gray_cycle(unsigned n, F const& visit)
+{
+  // Visit takes (value, step). Example: visit(word, k).
+  uint64_t const count = uint64_t{1} << n;
+
+  uint64_t g = 0;
+  visit(g, 0);
+
+  for (uint64_t k = 1; k < count; ++k)
+  {
+    unsigned bit = std::countr_zero(k);        // Index of least-significant 1 in k.
+    g ^= (uint64_t{1} << bit);                 // Flip exactly that bit.
+    visit(g, k);
+  }
+
+  // Optional: one could check that last→first differs by one bit:
+  // (g ^ 0) has exactly one bit set when k == count - 1.
+}
+
+// Same as visit_gray_cycle, but only visit steps [k0, k1).
+// The range is seeded directly with gray_code(k0), so that a cycle can be split into independent chunks.
+template <typename F>
+void visit_gray_range(uint64_t k0, uint64_t k1, F&& visit)
+{
+  if (k0 >= k1)
+    return;
+  uint64_t g = gray_code(k0);
+  visit(g, k0);
+  for (uint64_t k = k0 + 1; k < k1; ++k)
+  {
+    g ^= uint64_t{1} << std::countr_zero(k);
+    visit(g, k);
+  }
+}
+
+// Visit steps [k0, k1) in blocks of block_size consecutive codes: visit(codes, k) is called with
+// the codes of steps k, k + 1, ..., k + block_size - 1.
+//
+// If k is a multiple of block_size, the codes of a block only differ in their lowest log2(block_size) bits:
+// gray_code(k + i) = gray_code(k) ^ gray_code(i). Therefore a block is one XOR of a constant table, without
+// a dependency between consecutive codes, and the visitor gets a fixed-size array that it can vectorize over.
+// Both k0 and k1 must be multiples of block_size.
+template <std::size_t block_size, typename F>
+void visit_gray_blocks(uint64_t k0, uint64_t k1, F&& visit)
+{
+  static_assert(std::has_single_bit(block_size) && 8 <= block_size && block_size <= 64, "block_size must be 8, 16, 32 or 64.");
+  ASSERT(k0 % block_size == 0 && k1 % block_size == 0);
+
+  static constexpr std::array<uint64_t, block_size> block_offset = []{
+    std::array<uint64_t, block_size> offsets;
+    for (std::size_t i = 0; i < block_size; ++i)
+      offsets[i] = gray_code(i);
+    return offsets;
+  }();
+
+  alignas(64) std::array<uint64_t, block_size> codes;
+  for (uint64_t k = k0; k < k1; k += block_size)
+  {
+    uint64_t const base = gray_code(k);
+    for (std::size_t i = 0; i < block_size; ++i)
+      codes[i] = base ^ block_offset[i];
+    visit(std::span<uint64_t const, block_size>{codes}, k);
+  }
+}
+
+// Visit all n-bit Gray codes with number_of_threads threads, in blocks of block_size codes (see visit_gray_blocks).
+//
+// The cycle is cut into chunks of chunk_size steps that the threads take from a shared counter until
+// none are left, so that a thread that is slowed down doesn't hold up the others. Each thread uses
+// its own copy of visitor (the visitors are therefore never shared between threads); the copies are
+// returned so that their results can be combined. Blocks are visited in order within a chunk, but the
+// order of the chunks is undefined.
+//
+// The number of codes, 2^n, must be a multiple of block_size.
+template <std::size_t block_size, typename Visitor>
+std::vector<Visitor> parallel_visit_gray_blocks(unsigned n, unsigned number_of_threads, Visitor const& visitor,
+    uint64_t chunk_size = uint64_t{1} << 16)
+{
+  uint64_t const count = uint64_t{1} << n;
+  ASSERT(count % block_size == 0 && number_of_threads > 0);
+  chunk_size = std::clamp<uint64_t>(std::bit_floor(chunk_size), block_size, count);
+  uint64_t const number_of_chunks = count / chunk_size;
+
+  // Put each visitor in its own cache line.
+  struct alignas(64) Slot
+  {
+    Visitor visitor;
+  };
+  std::vector<Slot> slots(number_of_threads, Slot{visitor});
+
+  std::atomic<uint64_t> next_chunk{0};
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < number_of_threads; ++t)
+    threads.emplace_back([&next_chunk, &slot = slots[t], number_of_chunks, chunk_size](){
+      for (uint64_t chunk; (chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) < number_of_chunks;)
+        visit_gray_blocks<block_size>(chunk * chunk_size, (chunk + 1) * chunk_size, slot.visitor);
+    });
+  for (std::thread& thread : threads)
+    thread.join();
+
+  std::vector<Visitor> visitors;
+  visitors.reserve(number_of_threads);
+  for (Slot& slot : slots)
+    visitors.push_back(std::move(slot.visitor));
+  return visitors;
+}
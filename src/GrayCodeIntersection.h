@@ -0,0 +1,146 @@
+#pragma once
+
+#include "GrayCode.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// The intersection of an n-dimensional hyperblock with the hyperplane normal·x + offset = 0,
+// by walking the 2^n corners in Gray code order.
+//
+// Consecutive corners of a Gray code differ in one coordinate, so the value of the plane equation
+// is updated with a single add or subtract per corner, instead of an n-term dot product. Only the
+// sign of every corner is stored (one bit each); an edge is crossed when the signs of its two
+// corners differ. The Gray code walk itself only traverses 2^n - 1 of the n·2^(n-1) edges, therefore
+// the crossings are found afterwards by comparing the sign bits of all neighbours along each axis,
+// 64 corners at a time.
+//
+// Corners are numbered by a bit mask c: bit k is set if coordinate k of the corner is hi[k] (otherwise lo[k]).
+// An edge is identified by its lower corner c (with bit k clear) and its axis k.
+template<int n>
+class GrayCodeIntersection
+{
+ public:
+  using point_type = std::array<double, n>;
+  static_assert(0 < n && n < 64, "The corners are numbered with an uint64_t.");
+
+ private:
+  static constexpr uint64_t number_of_corners = uint64_t{1} << n;
+  // After this many steps the running value is recalculated from scratch, to bound the accumulated rounding error.
+  static constexpr uint64_t resync_interval = 4096;
+
+  point_type lo_;
+  point_type hi_;
+  double base_;                         // normal·lo.
+  point_type delta_;                    // delta_[k] = normal[k] * (hi[k] - lo[k]): the change of the value when bit k is set.
+  std::vector<uint64_t> negative_;      // Bit c is set if corner c is on the negative side of the plane.
+
+  // The value of normal·corner(c), calculated directly.
+  double value(uint64_t c) const
+  {
+    double result = base_;
+    for (uint64_t bits = c; bits; bits &= bits - 1)
+      result += delta_[std::countr_zero(bits)];
+    return result;
+  }
+
+ public:
+  GrayCodeIntersection(point_type const& lo, point_type const& hi, point_type const& normal) :
+    lo_(lo), hi_(hi), base_(0.0), negative_((number_of_corners + 63) / 64)
+  {
+    for (int k = 0; k < n; ++k)
+    {
+      base_ += normal[k] * lo[k];
+      delta_[k] = normal[k] * (hi[k] - lo[k]);
+    }
+  }
+
+  // Calculate the side of the plane of every corner, for the plane with offset.
+  void set_offset(double offset)
+  {
+    double v = base_ + offset;
+    uint64_t previous = 0;
+    // The 64 codes of steps 64m up till and including 64m + 63 only differ in their lowest six bits,
+    // so their sign bits are collected in a register and written to negative_ as one word.
+    uint64_t word = 0;
+    visit_gray_cycle(n, [&](uint64_t g, uint64_t step){
+      if (step % resync_interval == 0)
+        v = value(g) + offset;
+      else
+      {
+        // Exactly one bit changed.
+        uint64_t const flipped = g ^ previous;
+        double const d = delta_[std::countr_zero(flipped)];
+        v += (g & flipped) ? d : -d;
+      }
+      previous = g;
+      word |= uint64_t{v < 0.0} << (g % 64);
+      if (step % 64 == 63 || step == number_of_corners - 1)
+      {
+        negative_[g / 64] = word;
+        word = 0;
+      }
+    });
+  }
+
+  // Call visitor(c, k) for every edge (c, k) whose corners are on different sides of the plane of the last set_offset.
+  // Returns the number of crossed edges.
+  template<typename Visitor>
+  uint64_t for_each_crossed_edge(Visitor&& visitor) const
+  {
+    // Within a 64-bit word, mask[k] selects the corners that have bit k clear.
+    static constexpr std::array<uint64_t, 6> mask = {
+      0x5555555555555555, 0x3333333333333333, 0x0f0f0f0f0f0f0f0f, 0x00ff00ff00ff00ff, 0x0000ffff0000ffff, 0x00000000ffffffff
+    };
+    uint64_t count = 0;
+    auto emit = [&](uint64_t word_index, uint64_t crossed, int k){
+      for (; crossed; crossed &= crossed - 1)
+      {
+        visitor(word_index * 64 + std::countr_zero(crossed), k);
+        ++count;
+      }
+    };
+    std::size_t const number_of_words = negative_.size();
+    for (int k = 0; k < n; ++k)
+    {
+      if (k < 6)
+      {
+        // Both corners are in the same word.
+        int const shift = 1 << k;
+        for (std::size_t w = 0; w < number_of_words; ++w)
+          emit(w, (negative_[w] ^ (negative_[w] >> shift)) & mask[k], k);
+      }
+      else
+      {
+        // The corners are in words w and w | other.
+        std::size_t const other = std::size_t{1} << (k - 6);
+        for (std::size_t w = 0; w < number_of_words; ++w)
+          if (!(w & other))
+            emit(w, negative_[w] ^ negative_[w | other], k);
+      }
+    }
+    return count;
+  }
+
+  // Return the point where the plane with offset crosses edge (c, k).
+  point_type intersection_point(uint64_t c, int k, double offset) const
+  {
+    double const v0 = value(c) + offset;
+    double const v1 = v0 + delta_[k];
+    point_type point;
+    for (int j = 0; j < n; ++j)
+      point[j] = (c >> j & 1) ? hi_[j] : lo_[j];
+    point[k] = lo_[k] + v0 / (v0 - v1) * (hi_[k] - lo_[k]);
+    return point;
+  }
+
+  // Convenience function for small n: all intersection points of the plane with offset.
+  std::vector<point_type> intersection_points(double offset)
+  {
+    set_offset(offset);
+    std::vector<point_type> points;
+    for_each_crossed_edge([&](uint64_t c, int k){ points.push_back(intersection_point(c, k, offset)); });
+    return points;
+  }
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+// The intersection of a fixed n-dimensional hyperblock with the hyperplanes normal·x + offset = 0,
+// for a sequence of offsets.
+//
+// math::Hyperblock<n>::intersection_points examines all n·2^(n-1) edges of the hyperblock for every
+// plane. Here the value normal·v of every corner v is calculated once, and the corners are sorted by it.
+// An edge is crossed by the plane when exactly one of its corners is on the negative side
+// (normal·v + offset < 0). When the offset changes, only the corners that the plane passes change side;
+// each of those toggles its n edges in the set of crossed edges. Sweeping through a sorted list of
+// offsets therefore costs O(n) per corner passed, plus the number of intersection points per offset.
+//
+// Corners are numbered by a bit mask c: bit k is set if coordinate k of the corner is hi[k] (otherwise lo[k]).
+// An edge is identified by its lower corner c (with bit k clear) and its axis k.
+template<int n>
+class HyperplaneSweep
+{
+ public:
+  using point_type = std::array<double, n>;
+  // The largest edge index, (2^n - 1) * n + n - 1, must be less than no_edge; that holds up till n = 27.
+  static_assert(0 < n && n < 28, "The edge indices c * n + k must fit in an uint32_t.");
+
+ private:
+  static constexpr uint32_t number_of_corners = uint32_t{1} << n;
+  static constexpr uint32_t no_edge = ~uint32_t{0};
+
+  point_type lo_;                                       // The corner with the smallest coordinates.
+  point_type hi_;                                       // The corner with the largest coordinates.
+  std::vector<double> value_;                           // value_[c] = normal·corner(c).
+  std::vector<uint32_t> sorted_corners_;                // All corners, sorted by value_.
+  uint32_t number_below_ = 0;                           // The first number_below_ corners of sorted_corners_ are on the negative side.
+  std::vector<uint32_t> crossed_edges_;                 // The edges (c * n + k) that are currently crossed by the plane.
+  std::vector<uint32_t> position_;                      // position_[c * n + k] is the index of that edge in crossed_edges_, or no_edge.
+  std::vector<point_type> intersection_points_;         // The result of the last call to intersection_points.
+
+  // Corner c changed side: every edge that it is part of toggles between crossed and not crossed.
+  void toggle_corner(uint32_t c)
+  {
+    for (int k = 0; k < n; ++k)
+    {
+      uint32_t const edge = (c & ~(uint32_t{1} << k)) * n + k;
+      uint32_t& position = position_[edge];
+      if (position == no_edge)
+      {
+        position = crossed_edges_.size();
+        crossed_edges_.push_back(edge);
+      }
+      else
+      {
+        // Remove the edge by moving the last element into its place.
+        uint32_t const last = crossed_edges_.back();
+        crossed_edges_[position] = last;
+        position_[last] = position;
+        crossed_edges_.pop_back();
+        position = no_edge;
+      }
+    }
+  }
+
+ public:
+  HyperplaneSweep(point_type const& lo, point_type const& hi, point_type const& normal) :
+    lo_(lo), hi_(hi), value_(number_of_corners), sorted_corners_(number_of_corners), position_(std::size_t{number_of_corners} * n, no_edge)
+  {
+    // Each corner differs from the one with its lowest set bit cleared in one coordinate only.
+    value_[0] = 0.0;
+    for (int k = 0; k < n; ++k)
+      value_[0] += normal[k] * lo[k];
+    for (uint32_t c = 1; c < number_of_corners; ++c)
+    {
+      int const k = std::countr_zero(c);
+      value_[c] = value_[c & (c - 1)] + normal[k] * (hi[k] - lo[k]);
+    }
+    std::iota(sorted_corners_.begin(), sorted_corners_.end(), uint32_t{0});
+    std::sort(sorted_corners_.begin(), sorted_corners_.end(), [this](uint32_t c1, uint32_t c2){ return value_[c1] < value_[c2]; });
+  }
+
+  // Move the plane to offset and return the points where it intersects with the edges of the hyperblock.
+  // The returned reference is valid until the next call. Any sequence of offsets is allowed, but
+  // a sorted sequence only passes every corner once.
+  std::vector<point_type> const& intersection_points(double offset)
+  {
+    // A corner c is on the negative side iff value_[c] < -offset.
+    double const threshold = -offset;
+    while (number_below_ < number_of_corners && value_[sorted_corners_[number_below_]] < threshold)
+      toggle_corner(sorted_corners_[number_below_++]);
+    while (number_below_ > 0 && !(value_[sorted_corners_[number_below_ - 1]] < threshold))
+      toggle_corner(sorted_corners_[--number_below_]);
+
+    intersection_points_.resize(crossed_edges_.size());
+    for (std::size_t i = 0; i < crossed_edges_.size(); ++i)
+    {
+      uint32_t const c = crossed_edges_[i] / n;
+      int const k = crossed_edges_[i] % n;
+      double const v0 = value_[c] + offset;
+      double const v1 = value_[c | (uint32_t{1} << k)] + offset;
+      point_type& point = intersection_points_[i];
+      for (int j = 0; j < n; ++j)
+        point[j] = (c >> j & 1) ? hi_[j] : lo_[j];
+      point[k] = lo_[k] + v0 / (v0 - v1) * (hi_[k] - lo_[k]);
+    }
+    return intersection_points_;
+  }
+
+  // The number of edges crossed by the plane at the last offset.
+  std::size_t number_of_intersection_points() const { return crossed_edges_.size(); }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Clipper.h"
+#include "PointArray.h"
+#include "Transform.h"
+#include "cairowindow/Line.h"
+#include <cstddef>
+#include <vector>
+
+// Bulk clipping of infinite lines (grid lines, regression lines, ...) to a window.
+//
+// A LineArray<cs> stores the lines in structure-of-arrays layout. clipper::clip_and_map maps every line
+// to to_cs and clips it against a rectangle in to_cs in a single pass, writing the visible pieces to a
+// LinePieceArray<to_cs>. No draw objects and no per-line allocations are involved; the caller decides
+// what to do with the pieces.
+
+// A batch of infinite lines in coordinate system cs.
+template<CS cs>
+class LineArray
+{
+ private:
+  PointArray<cs> points_;               // A point on each line.
+  VectorArray<cs> directions_;          // The direction of each line (need not be normalized).
+
+ public:
+  std::size_t size() const { return points_.size(); }
+  bool empty() const { return points_.empty(); }
+  void reserve(std::size_t n) { points_.reserve(n); directions_.reserve(n); }
+  void clear() { points_.clear(); directions_.clear(); }
+
+  void push_back(Point<cs> const& point, Vector<cs> const& direction)
+  {
+    // A line needs a direction.
+    ASSERT(direction.x() != 0.0 || direction.y() != 0.0);
+    points_.push_back(point);
+    directions_.push_back(direction);
+  }
+
+  void push_back(Line<cs> const& line)
+  {
+    push_back(Point<cs>{line.point()}, Vector<cs>{line.direction()});
+  }
+
+  PointArray<cs> const& points() const { return points_; }
+  VectorArray<cs> const& directions() const { return directions_; }
+};
+
+template<CS cs>
+class LinePieceArray;
+
+namespace clipper::detail {
+
+template<CS from_cs, CS to_cs>
+std::size_t clip_and_map(AffineCoefficients const& m, LineArray<from_cs> const& lines,
+    Rectangle<to_cs> const& rectangle, LinePieceArray<to_cs>& pieces);
+
+} // namespace clipper::detail
+
+// The visible pieces of a LineArray, in coordinate system cs.
+template<CS cs>
+class LinePieceArray
+{
+ private:
+  template<CS from_cs, CS to_cs>
+  friend std::size_t clipper::detail::clip_and_map(AffineCoefficients const& m, LineArray<from_cs> const& lines,
+      Rectangle<to_cs> const& rectangle, LinePieceArray<to_cs>& pieces);
+
+  PointArray<cs> from_;                 // The point where each piece enters the rectangle (the negative side of its line).
+  PointArray<cs> to_;                   // The point where each piece leaves the rectangle.
+  std::vector<std::size_t> indices_;    // The index of the line of each piece, in the LineArray that was clipped.
+
+ public:
+  std::size_t size() const { return from_.size(); }
+  bool empty() const { return from_.empty(); }
+
+  PointArray<cs> const& from() const { return from_; }
+  PointArray<cs> const& to() const { return to_; }
+  std::size_t index(std::size_t i) const { return indices_[i]; }
+
+  cairowindow::LinePiece line_piece(std::size_t i) const { return {from_[i], to_[i]}; }
+};
+
+namespace clipper {
+
+namespace detail {
+
+// Map the lines (px, py) + t * (dx, dy) through m and clip them against bounds, all in one pass.
+// Writes the visible pieces and the indices of their lines to the start of the output arrays,
+// which must be at least n long, and returns the number of visible pieces.
+inline std::size_t clip_and_map(AffineCoefficients const& m,
+    double const* __restrict px, double const* __restrict py, double const* __restrict dx, double const* __restrict dy, std::size_t n,
+    Bounds const& bounds,
+    double* __restrict from_x, double* __restrict from_y, double* __restrict to_x, double* __restrict to_y, std::size_t* __restrict indices)
+{
+  std::size_t visible = 0;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    // The point is mapped like a point, the direction like a vector (without the translation).
+    double const x = m.m11 * px[i] + m.m21 * py[i] + m.dx;
+    double const y = m.m12 * px[i] + m.m22 * py[i] + m.dy;
+    double const u = m.m11 * dx[i] + m.m21 * dy[i];
+    double const v = m.m12 * dx[i] + m.m22 * dy[i];
+    double t_enter = 0.0;
+    double t_exit = 0.0;
+    // A singular transform can map the direction to zero; such a line has no visible piece.
+    bool const is_visible = (u != 0.0 || v != 0.0) && clip(x, y, u, v, bounds, t_enter, t_exit);
+    // Always write, but only advance the output position for visible lines.
+    from_x[visible] = x + t_enter * u;
+    from_y[visible] = y + t_enter * v;
+    to_x[visible] = x + t_exit * u;
+    to_y[visible] = y + t_exit * v;
+    indices[visible] = i;
+    visible += is_visible;
+  }
+  return visible;
+}
+
+// Map lines through m, clip them against rectangle and replace the contents of pieces with the result.
+// Returns the number of visible pieces. The coefficients carry no coordinate systems, therefore this
+// is only called by the public overloads below, which take them from a Transform or TransformChain.
+template<CS from_cs, CS to_cs>
+std::size_t clip_and_map(AffineCoefficients const& m, LineArray<from_cs> const& lines,
+    Rectangle<to_cs> const& rectangle, LinePieceArray<to_cs>& pieces)
+{
+  std::size_t const n = lines.size();
+  pieces.from_.resize(n);
+  pieces.to_.resize(n);
+  pieces.indices_.resize(n);
+  std::size_t const visible = clip_and_map(m,
+      lines.points().x().data(), lines.points().y().data(), lines.directions().x().data(), lines.directions().y().data(), n,
+      rectangle,
+      pieces.from_.x().data(), pieces.from_.y().data(), pieces.to_.x().data(), pieces.to_.y().data(), pieces.indices_.data());
+  pieces.from_.resize(visible);
+  pieces.to_.resize(visible);
+  pieces.indices_.resize(visible);
+  return visible;
+}
+
+} // namespace detail
+
+// Map lines through transform, clip them against rectangle and replace the contents of pieces with the result.
+// Returns the number of visible pieces.
+template<CS from_cs, CS to_cs, bool inverted>
+std::size_t clip_and_map(LineArray<from_cs> const& lines, Transform<from_cs, to_cs, inverted> const& transform,
+    Rectangle<to_cs> const& rectangle, LinePieceArray<to_cs>& pieces)
+{
+  return detail::clip_and_map(transform.matrix().coefficients(), lines, rectangle, pieces);
+}
+
+template<CS from_cs, CS to_cs, typename... Links>
+std::size_t clip_and_map(LineArray<from_cs> const& lines, TransformChain<from_cs, to_cs, Links...> const& chain,
+    Rectangle<to_cs> const& rectangle, LinePieceArray<to_cs>& pieces)
+{
+  return detail::clip_and_map(chain.forward().coefficients(), lines, rectangle, pieces);
+}
+
+} // namespace clipper
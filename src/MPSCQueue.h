@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// A lock-free multi-producer, single-consumer queue.
+//
+// Producers push with a single compare-and-swap on the head of a singly linked list. The consumer
+// takes the whole list at once with an exchange and reverses it, so that elements are handed out in
+// the order in which they were pushed (per producer). Because the consumer never pops individual
+// nodes, there is no ABA problem.
+//
+// Each push allocates one node; push whole batches of work, not single objects.
+template<typename T>
+class MPSCQueue
+{
+ private:
+  struct Node
+  {
+    T value;
+    Node* next;
+  };
+
+  std::atomic<Node*> head_{nullptr};    // The most recently pushed node.
+
+ public:
+  MPSCQueue() = default;
+  MPSCQueue(MPSCQueue const&) = delete;
+  MPSCQueue& operator=(MPSCQueue const&) = delete;
+
+  ~MPSCQueue()
+  {
+    drain([](T&&){ });
+  }
+
+  // Thread-safe: may be called by any number of threads concurrently.
+  void push(T value)
+  {
+    Node* node = new Node{std::move(value), head_.load(std::memory_order_relaxed)};
+    while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+      ;
+  }
+
+  // Call consumer(T&&) for every element that was pushed so far, oldest first, and return how many there were.
+  // May only be called by one thread at a time.
+  template<typename Consumer>
+  std::size_t drain(Consumer&& consumer)
+  {
+    Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+    // Reverse the list.
+    Node* oldest = nullptr;
+    while (node)
+    {
+      Node* next = node->next;
+      node->next = oldest;
+      oldest = node;
+      node = next;
+    }
+    std::size_t count = 0;
+    while (oldest)
+    {
+      Node* next = oldest->next;
+      consumer(std::move(oldest->value));
+      delete oldest;
+      oldest = next;
+      ++count;
+    }
+    return count;
+  }
+};
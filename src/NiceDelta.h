@@ -4,10 +4,67 @@
 #include "math/subsuper_string.h"
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <charconv>
 #include <cmath>
+#include <cstdint>
 #include <iomanip>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "debug.h"
+
+namespace detail {
+
+// Powers of ten, 10^min_exponent ... 10^max_exponent.
+//
+// Each entry is calculated with std::pow(10.0, exponent) so that using the table
+// gives bit-identical results to calling std::pow directly.
+class Pow10Table
+{
+ public:
+  static constexpr int min_exponent = -300;
+  static constexpr int max_exponent = 300;
+
+ private:
+  std::array<double, max_exponent - min_exponent + 1> table_;
+
+  Pow10Table()
+  {
+    for (int exponent = min_exponent; exponent <= max_exponent; ++exponent)
+      table_[exponent - min_exponent] = std::pow(10.0, exponent);
+  }
+
+ public:
+  static Pow10Table const& instance()
+  {
+    static Pow10Table const s_instance;
+    return s_instance;
+  }
+
+  // The table itself; element i is 10^(min_exponent + i).
+  double const* data() const
+  {
+    return table_.data();
+  }
+
+  static constexpr bool contains(int exponent)
+  {
+    return min_exponent <= exponent && exponent <= max_exponent;
+  }
+
+  // Return 10^exponent. The exponent must be in the range [min_exponent, max_exponent].
+  double operator[](int exponent) const
+  {
+    return table_[exponent - min_exponent];
+  }
+};
+
+} // namespace detail
 
 template<CS cs>
 class NiceDelta
@@ -17,6 +74,24 @@ class NiceDelta
   static constexpr std::array<int, number_of_mantissa_values> mantissa_values = { 1, 2, 5 };
   static constexpr int invalid_magic = -2;
 
+  // A tick label stored in a fixed size buffer, as returned by fixed_capacity_label.
+  class Label
+  {
+   public:
+    // Large enough for any label: at most 20 characters are needed (a ten digit k times 5·10^4, with sign and three decimals).
+    static constexpr std::size_t capacity = 32;
+
+   private:
+    std::array<char, capacity> buffer_;
+    std::size_t size_ = 0;
+
+    friend class NiceDelta;
+
+   public:
+    std::string_view view() const { return {buffer_.data(), size_}; }
+    operator std::string_view() const { return view(); }
+  };
+
  private:
   int mantissa_;
   int exponent_;
@@ -44,14 +119,230 @@ class NiceDelta
 
   static int calculate_m(Range<cs> const& range, double delta)
   {
-    return static_cast<int>(std::floor(range.max() / delta) - std::ceil(range.min() / delta)) + 1;
+    return calculate_m(range.min(), range.max(), delta);
+  }
+
+  // Given that mantissa_ and exponent_ describe the smallest nice value that is larger or equal to range.size() / 9,
+  // and that current_value is that value, calculate m_ and possibly switch to the next smaller value.
+  void refine(Range<cs> const& range, double current_value)
+  {
+    // Calculate m for the current value.
+    m_ = calculate_m(range, current_value);
+
+    // A value of 6 or larger is the correct value: a smaller delta would lead to an m of more than 10.
+    if (m_ <= 5)
+    {
+      // Try the next smaller value of the current NiceDelta.
+      NiceDelta next_smaller_delta(mantissa_ - 1, exponent_);
+      int next_m = calculate_m(range, next_smaller_delta.value());
+
+      if (m_ < 5 || next_m <= 10)
+      {
+        exponent_ = next_smaller_delta.exponent_;
+        mantissa_ = next_smaller_delta.mantissa_;
+        m_ = next_m;
+      }
+    }
+  }
+
+  static int calculate_m(double min, double max, double delta)
+  {
+    return static_cast<int>(std::floor(max / delta) - std::ceil(min / delta)) + 1;
+  }
+
+  // The table driven algorithm, without branches, for the range [min, max].
+  //
+  // Returns false if the range can't be handled because range.size() / 9 isn't a positive
+  // normal number, or its power of ten is too close to the ends of the table; in that case
+  // the values written to mantissa, exponent and m are meaningless.
+  static bool compute(double min, double max, detail::Pow10Table const& pow10, int& mantissa, int& exponent, int& m)
+  {
+    // Dividing by 9 guarantees that m() will return a value less than 10,
+    // which then is guaranteed not larger than the sought for value.
+    double ideal_delta = (max - min) / 9;
+
+    // Estimate floor(log10(ideal_delta)) from the binary exponent of ideal_delta, read directly from its bit
+    // representation: 78913 / 2^18 is slightly less than log10(2). The estimate is exact or one too small
+    // for every normal double.
+    int const binary_exponent = static_cast<int>((std::bit_cast<uint64_t>(ideal_delta) >> 52) & 0x7ff) - 1023;
+    int e = (binary_exponent * 78913) >> 18;
+
+    // Continue with harmless values when the range can't be handled, so that no undefined behavior can happen.
+    // Use & instead of && because the latter introduces branches.
+    bool const valid = (ideal_delta > 0.0) & (e - 1 >= detail::Pow10Table::min_exponent) & (e + 2 <= detail::Pow10Table::max_exponent);
+    ideal_delta = valid ? ideal_delta : 1.0;
+    min = valid ? min : 0.0;
+    max = valid ? max : 9.0;
+    e = valid ? e : 0;
+
+    e += pow10[e + 1] < ideal_delta;
+
+    // Now 10^e < ideal_delta <= 10^(e + 1), up to rounding of the table values.
+    // Find the smallest of 1·10^e, 2·10^e, 5·10^e and 1·10^(e + 1) that is greater or equal ideal_delta;
+    // the same value that the increment loop of the reference algorithm finds.
+    double const power = pow10[e];
+    int const smaller_count =
+      (mantissa_values[0] * power < ideal_delta) + (mantissa_values[1] * power < ideal_delta) + (mantissa_values[2] * power < ideal_delta);
+    bool const carry = smaller_count == number_of_mantissa_values;
+    int mant = carry ? 0 : smaller_count;
+    e += carry;
+    double const current_value = mantissa_values[mant] * pow10[e];
+    int const current_m = calculate_m(min, max, current_value);
+
+    // The refinement step of refine(): try the next smaller value if current_m <= 5.
+    bool const borrow = mant == 0;
+    int const next_mant = borrow ? number_of_mantissa_values - 1 : mant - 1;
+    int const next_e = e - borrow;
+    int const next_m = calculate_m(min, max, mantissa_values[next_mant] * pow10[next_e]);
+    bool const use_next = (current_m < 5) | ((current_m == 5) & (next_m <= 10));
+
+    mantissa = use_next ? next_mant : mant;
+    exponent = use_next ? next_e : e;
+    m = use_next ? next_m : current_m;
+    return valid;
+  }
+
+#if defined(__AVX2__)
+  // Narrow four 64-bit lanes (masks or small integers) to four 32-bit lanes.
+  static __m128i narrow(__m256i v)
+  {
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0)));
+  }
+
+  static __m128i narrow(__m256d mask)
+  {
+    return narrow(_mm256_castpd_si256(mask));
+  }
+
+  // Return table[index[i]] for the four lanes.
+  static __m256d gather(double const* table, __m128i index)
+  {
+    // Use the masked version because _mm256_i32gather_pd triggers a -Wuninitialized false positive in g++.
+    __m256d const all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table, index, all_lanes, 8);
+  }
+
+  // Return calculate_m(min, max, delta) for four lanes.
+  static __m128i calculate_m(__m256d min, __m256d max, __m256d delta)
+  {
+    __m256d const difference = _mm256_sub_pd(_mm256_floor_pd(_mm256_div_pd(max, delta)), _mm256_ceil_pd(_mm256_div_pd(min, delta)));
+    return _mm_add_epi32(_mm256_cvttpd_epi32(difference), _mm_set1_epi32(1));
+  }
+
+  // The same as compute(min, max, pow10, mantissa, exponent, m), but for ranges[0] through ranges[3] at once.
+  // Returns a four bit mask with bit i set when ranges[i] was handled.
+  static int compute(Range<cs> const* ranges, detail::Pow10Table const& pow10, int* mantissa, int* exponent, int* m)
+  {
+    static constexpr double mantissa_doubles[number_of_mantissa_values] = { 1.0, 2.0, 5.0 };
+    double const* const table = pow10.data();
+    __m128i const table_offset = _mm_set1_epi32(-detail::Pow10Table::min_exponent);
+
+    __m256d min = _mm256_setr_pd(ranges[0].min(), ranges[1].min(), ranges[2].min(), ranges[3].min());
+    __m256d max = _mm256_setr_pd(ranges[0].max(), ranges[1].max(), ranges[2].max(), ranges[3].max());
+    __m256d ideal_delta = _mm256_div_pd(_mm256_sub_pd(max, min), _mm256_set1_pd(9.0));
+
+    __m256i const biased_exponent = _mm256_and_si256(_mm256_srli_epi64(_mm256_castpd_si256(ideal_delta), 52), _mm256_set1_epi64x(0x7ff));
+    __m128i const binary_exponent = _mm_sub_epi32(narrow(biased_exponent), _mm_set1_epi32(1023));
+    __m128i e = _mm_srai_epi32(_mm_mullo_epi32(binary_exponent, _mm_set1_epi32(78913)), 18);
+
+    __m128i const valid = _mm_and_si128(narrow(_mm256_cmp_pd(ideal_delta, _mm256_setzero_pd(), _CMP_GT_OQ)),
+        _mm_and_si128(_mm_cmpgt_epi32(e, _mm_set1_epi32(detail::Pow10Table::min_exponent)),
+                      _mm_cmplt_epi32(e, _mm_set1_epi32(detail::Pow10Table::max_exponent - 1))));
+    __m256d const valid_pd = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(valid));
+    ideal_delta = _mm256_blendv_pd(_mm256_set1_pd(1.0), ideal_delta, valid_pd);
+    min = _mm256_blendv_pd(_mm256_setzero_pd(), min, valid_pd);
+    max = _mm256_blendv_pd(_mm256_set1_pd(9.0), max, valid_pd);
+    e = _mm_and_si128(e, valid);
+
+    // Comparison masks are -1 (all bits set) for true, so subtracting them adds one.
+    __m128i index = _mm_add_epi32(e, table_offset);
+    __m256d const next_power = gather(table, _mm_add_epi32(index, _mm_set1_epi32(1)));
+    index = _mm_sub_epi32(index, narrow(_mm256_cmp_pd(next_power, ideal_delta, _CMP_LT_OQ)));
+
+    __m256d const power = gather(table, index);
+    __m128i smaller_count = _mm_setzero_si128();
+    for (int i = 0; i < number_of_mantissa_values; ++i)
+    {
+      __m256d const candidate = _mm256_mul_pd(_mm256_set1_pd(mantissa_doubles[i]), power);
+      smaller_count = _mm_sub_epi32(smaller_count, narrow(_mm256_cmp_pd(candidate, ideal_delta, _CMP_LT_OQ)));
+    }
+    __m128i const carry = _mm_cmpeq_epi32(smaller_count, _mm_set1_epi32(number_of_mantissa_values));
+    __m128i const mant = _mm_andnot_si128(carry, smaller_count);
+    index = _mm_sub_epi32(index, carry);
+    __m256d const current_value = _mm256_mul_pd(gather(mantissa_doubles, mant), gather(table, index));
+    __m128i const current_m = calculate_m(min, max, current_value);
+
+    __m128i const borrow = _mm_cmpeq_epi32(mant, _mm_setzero_si128());
+    __m128i const next_mant = _mm_blendv_epi8(_mm_sub_epi32(mant, _mm_set1_epi32(1)), _mm_set1_epi32(number_of_mantissa_values - 1), borrow);
+    __m128i const next_index = _mm_add_epi32(index, borrow);
+    __m256d const next_value = _mm256_mul_pd(gather(mantissa_doubles, next_mant), gather(table, next_index));
+    __m128i const next_m = calculate_m(min, max, next_value);
+
+    __m128i const use_next = _mm_or_si128(_mm_cmplt_epi32(current_m, _mm_set1_epi32(5)),
+        _mm_and_si128(_mm_cmpeq_epi32(current_m, _mm_set1_epi32(5)), _mm_cmplt_epi32(next_m, _mm_set1_epi32(11))));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(mantissa), _mm_blendv_epi8(mant, next_mant, use_next));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(exponent), _mm_sub_epi32(_mm_blendv_epi8(index, next_index, use_next), table_offset));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(m), _mm_blendv_epi8(current_m, next_m, use_next));
+    return _mm_movemask_ps(_mm_castsi128_ps(valid));
   }
+#endif
 
  public:
+  // Tag type to select the original (log10 and increment loop) algorithm; used to test the fast path.
+  struct ReferenceAlgorithm { };
+
   // Construct an "invalid" NiceDelta.
   NiceDelta() : mantissa_(invalid_magic) { }
 
   NiceDelta(Range<cs> const& range)
+  {
+    if (!compute(range.min(), range.max(), detail::Pow10Table::instance(), mantissa_, exponent_, m_))
+    {
+      // Zero, negative, infinite, NaN, denormal or extremely small or large deltas.
+      *this = NiceDelta(range, ReferenceAlgorithm{});
+    }
+  }
+
+  // Calculate the NiceDelta of each range in ranges, writing the mantissa index, exponent and m
+  // of ranges[i] to mantissa[i], exponent[i] and m[i] respectively.
+  //
+  // The results are identical to those of the NiceDelta(Range) constructor.
+  static void compute(std::span<Range<cs> const> ranges, std::span<int> mantissa, std::span<int> exponent, std::span<int> m)
+  {
+    ASSERT(mantissa.size() >= ranges.size() && exponent.size() >= ranges.size() && m.size() >= ranges.size());
+    detail::Pow10Table const& pow10 = detail::Pow10Table::instance();
+
+    // First do all ranges with the branch-free algorithm, four at a time when AVX2 is available,
+    // remembering if there were any ranges that it can't handle.
+    bool all_valid = true;
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= ranges.size(); i += 4)
+      all_valid &= compute(&ranges[i], pow10, &mantissa[i], &exponent[i], &m[i]) == 0xf;
+#endif
+    for (; i < ranges.size(); ++i)
+      all_valid &= compute(ranges[i].min(), ranges[i].max(), pow10, mantissa[i], exponent[i], m[i]);
+
+    if (all_valid)
+      return;
+
+    // Redo the ranges that were not handled.
+    for (std::size_t i = 0; i < ranges.size(); ++i)
+    {
+      int unused_mantissa, unused_exponent, unused_m;
+      if (!compute(ranges[i].min(), ranges[i].max(), pow10, unused_mantissa, unused_exponent, unused_m))
+      {
+        NiceDelta const nice_delta(ranges[i], ReferenceAlgorithm{});
+        mantissa[i] = nice_delta.mantissa_;
+        exponent[i] = nice_delta.exponent_;
+        m[i] = nice_delta.m_;
+      }
+    }
+  }
+
+  // The original algorithm: uses std::log10 and then increments the value until it is large enough.
+  NiceDelta(Range<cs> const& range, ReferenceAlgorithm)
   {
     // Dividing by 9 guarantees that m() will return a value less than 10,
     // which then is guaranteed not larger than the sought for value.
@@ -66,7 +357,7 @@ class NiceDelta
     double current_value;
     for (;;)
     {
-      current_value = value();
+      current_value = mantissa_values[mantissa_] * std::pow(10.0, exponent_);
 
       // Exit once we found the first value that is greater or equal ideal_delta.
       if (current_value >= ideal_delta)
@@ -76,23 +367,7 @@ class NiceDelta
       increment();
     }
 
-    // Calculate m for the current value.
-    m_ = calculate_m(range, current_value);
-
-    // A value of 6 or larger is the correct value: a smaller delta would lead to an m of more than 10.
-    if (m_ <= 5)
-    {
-      // Try the next smaller value of the current NiceDelta.
-      NiceDelta next_smaller_delta(mantissa_ - 1, exponent_);
-      int next_m = calculate_m(range, next_smaller_delta.value());
-
-      if (m_ < 5 || next_m <= 10)
-      {
-        exponent_ = next_smaller_delta.exponent_;
-        mantissa_ = next_smaller_delta.mantissa_;
-        m_ = next_m;
-      }
-    }
+    refine(range, current_value);
   }
 
   bool is_invalid() const
@@ -100,8 +375,17 @@ class NiceDelta
     return mantissa_ == invalid_magic;
   }
 
+  friend bool operator==(NiceDelta const& lhs, NiceDelta const& rhs)
+  {
+    if (lhs.is_invalid() || rhs.is_invalid())
+      return lhs.is_invalid() && rhs.is_invalid();
+    return lhs.mantissa_ == rhs.mantissa_ && lhs.exponent_ == rhs.exponent_ && lhs.m_ == rhs.m_;
+  }
+
   double value() const
   {
+    if (detail::Pow10Table::contains(exponent_))
+      return mantissa_values[mantissa_] * detail::Pow10Table::instance()[exponent_];
     return mantissa_values[mantissa_] * std::pow(10.0, exponent_);
   }
 
@@ -110,6 +394,33 @@ class NiceDelta
     return m_;
   }
 
+  // Return the next finer tick level: the largest nice value that is smaller than value() and divides it;
+  // 1·10^e → 5·10^(e-1), 2·10^e → 1·10^e and 5·10^e → 1·10^e. Its m() is calculated for range.
+  NiceDelta finer(Range<cs> const& range) const
+  {
+    ASSERT(!is_invalid());
+    NiceDelta result(mantissa_ == 0 ? -1 : 0, exponent_);
+    result.m_ = calculate_m(range, result.value());
+    return result;
+  }
+
+  // Return the number of ticks of finer() per tick of this NiceDelta.
+  int subdivisions() const
+  {
+    return mantissa_values[mantissa_] == 5 ? 5 : 2;
+  }
+
+  // Return the index into mantissa_values.
+  int mantissa_index() const
+  {
+    return mantissa_;
+  }
+
+  int exponent() const
+  {
+    return exponent_;
+  }
+
   std::string label(int k) const
   {
     ASSERT(!is_invalid());
@@ -143,6 +454,55 @@ class NiceDelta
     return result;
   }
 
+  // Write the same text as label(k) into [first, last), without allocating memory.
+  // Returns a pointer one past the last written character. The buffer must have room for at least Label::capacity characters.
+  char* write_label(int k, char* first, char* last) const
+  {
+    ASSERT(!is_invalid());
+    ASSERT(last - first >= static_cast<std::ptrdiff_t>(Label::capacity));
+
+    double const delta_value = value();
+    double const tick_value = k * delta_value;
+
+    if (tick_value == 0.0)
+    {
+      *first = '0';
+      return first + 1;
+    }
+
+    if (exponent_ <= -4 || exponent_ > 4)
+    {
+      long long const scaled_integer = static_cast<long long>(k) * mantissa_values[mantissa_];
+      if (scaled_integer == 0)
+      {
+        *first = '0';
+        return first + 1;
+      }
+      // Leave room for the 'e' and the (at most four character) exponent.
+      char* ptr = std::to_chars(first, last - 5, scaled_integer).ptr;
+      *ptr++ = 'e';
+      return std::to_chars(ptr, last, exponent_).ptr;
+    }
+
+    // std::to_chars with a precision gives the same result as printf("%.*f"), and thus as a std::ostream with std::ios::fixed.
+    char* const end = std::to_chars(first, last, tick_value, std::chars_format::fixed, std::max(0, -exponent_)).ptr;
+    if (*first == '-' && std::find_if(first + 1, end, [](char c) { return c != '0' && c != '.'; }) == end)
+    {
+      // Strip the sign of a negative value that was rounded to zero.
+      std::copy(first + 1, end, first);
+      return end - 1;
+    }
+    return end;
+  }
+
+  // Return label(k) in a fixed capacity buffer.
+  Label fixed_capacity_label(int k) const
+  {
+    Label label;
+    label.size_ = write_label(k, label.buffer_.data(), label.buffer_.data() + Label::capacity) - label.buffer_.data();
+    return label;
+  }
+
 #ifdef CWDEBUG
   void print_on(std::ostream& os) const
   {
@@ -1,14 +1,20 @@
 #include "sys.h"
 #include "NiceDelta.h"
 #include "Range.h"
-#include <vector>
+#include "Stopwatch.h"
+#include "utils/almost_equal.h"
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
 #include "debug.h"
 
-#if CW_DEBUG
-#include "utils/almost_equal.h"
-#endif
-
 namespace bruteforce {
 
 // d = 5
@@ -31,10 +37,14 @@ class D
   int n_;
 
  public:
-  // Construct a D that has the value 10^-9.
-  D() : s_{1}, n_{-9} { }
   D(int s, int n) : s_(s), n_(n) { }
 
+  // Return a D that is at most size / 100, so that calculate_m returns a value larger than 10 for any range of that size.
+  static D starting_value(double size)
+  {
+    return {1, static_cast<int>(std::floor(std::log10(size))) - 2};
+  }
+
   operator double() const
   {
     return s_ * std::pow(10.0, n_);
@@ -76,31 +86,45 @@ class D
 // Let k2 be the largest possible integer such that k2 * d <= max.
 //
 // Let m = k2 - k1 + 1.
-uint64_t calculate_m(double min, double max, D const& d)
+//
+// Most values of d are not exactly representable, so a tick that mathematically lies on min or max
+// can end up just inside or outside of the range, depending on rounding. If snap is true then
+// min / d and max / d are rounded to the nearest integer when they are that close to it.
+double snap_to_integer(double x)
+{
+  // A few ulp: the rounding errors of d and of the division.
+  constexpr double epsilon = 4 * std::numeric_limits<double>::epsilon();
+  double const nearest = std::round(x);
+  return std::abs(x - nearest) <= epsilon * std::abs(x) ? nearest : x;
+}
+
+int64_t calculate_m(double min, double max, D const& d, bool snap)
 {
-  uint64_t k1 = std::ceil(min / d);
-  uint64_t k2 = std::floor(max / d);
+  double const kmin = min / d;
+  double const kmax = max / d;
+  int64_t k1 = std::ceil(snap ? snap_to_integer(kmin) : kmin);
+  int64_t k2 = std::floor(snap ? snap_to_integer(kmax) : kmax);
   return k2 - k1 + 1;
 }
 
-double brute_force_d(double min, double max, int& m_out)
+double brute_force_d(double min, double max, int& m_out, bool snap = false)
 {
   // What is the smallest d such that m <= 10.
-  D d;              // Start with 10^-8.
-  D prev_d;
-  uint64_t m = calculate_m(min, max, d);         // m gets smaller if d gets larger.
+  D d = D::starting_value(max - min);
+  D prev_d = d;
+  int64_t m = calculate_m(min, max, d, snap);   // m gets smaller if d gets larger.
   ASSERT(m > 10);                           // We assume that the initial m is always too large.
   while (m > 10)
   {
     prev_d = d;
     ++d;                                    // Try the next larger value of d.
-    m = calculate_m(min, max, d);
+    m = calculate_m(min, max, d, snap);
   }
   // If for that d-value m < 5, then just take the next smaller d (which is the largest d such that m >= 5).
   if (m < 5)
   {
     d = prev_d;
-    m = calculate_m(min, max, d);
+    m = calculate_m(min, max, d, snap);
   }
 
   m_out = m;
@@ -109,16 +133,10 @@ double brute_force_d(double min, double max, int& m_out)
 
 } // namespace bruteforce
 
-std::array<double, 8> test_powers = {
-  0.000001,
-  0.001,
-  0.1,
-  1.0,
-  10.0,
-  100.0,
-  1000.0,
-  100000.0
-};
+// The exhaustive grid: min = ±factor·10^p and max - min = 0.1·factor·10^p for every factor in test_factors
+// and min_test_exponent <= p <= max_test_exponent.
+constexpr int min_test_exponent = -12;
+constexpr int max_test_exponent = 12;
 
 std::array<double, 16> test_factors = {
   1.0,
@@ -139,40 +157,242 @@ std::array<double, 16> test_factors = {
   10.0
 };
 
-int main()
-{
-  Debug(NAMESPACE_DEBUG::init());
-
-  std::vector<double> min_values;
-  for (double power : test_powers)
-    for (double factor : test_factors)
-      min_values.push_back(factor * power);
+// Ranges that are so small relative to their position that ticks can't be represented accurately are skipped.
+constexpr double min_relative_size = 1e-9;
 
+std::vector<Range<CS::pixels>> grid_ranges()
+{
+  std::vector<double> min_values = { 0.0 };
   std::vector<double> max_minus_min_values;
-  for (double power : test_powers)
+  for (int p = min_test_exponent; p <= max_test_exponent; ++p)
     for (double factor : test_factors)
+    {
+      double const power = std::pow(10.0, p);
+      min_values.push_back(factor * power);
+      min_values.push_back(-factor * power);
       max_minus_min_values.push_back(0.1 * factor * power);
+    }
 
+  std::vector<Range<CS::pixels>> ranges;
   for (double min : min_values)
     for (double max_minus_min : max_minus_min_values)
+      if (max_minus_min >= min_relative_size * std::abs(min))
+        ranges.emplace_back(min, min + max_minus_min);
+  return ranges;
+}
+
+// Ranges with a random size between 10^min_test_exponent and 10^max_test_exponent and a random offset.
+std::vector<Range<CS::pixels>> random_ranges(std::size_t count, uint64_t seed)
+{
+  std::mt19937_64 engine(seed);
+  std::uniform_real_distribution<double> log_size_distribution(min_test_exponent, max_test_exponent);
+  std::uniform_real_distribution<double> offset_distribution(-10.0, 10.0);
+  std::vector<Range<CS::pixels>> ranges;
+  ranges.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    double const size = std::pow(10.0, log_size_distribution(engine));
+    double const min = offset_distribution(engine) * size;
+    ranges.emplace_back(min, min + size);
+  }
+  return ranges;
+}
+
+// The results of checking one shard of the ranges.
+struct ShardResult
+{
+  uint64_t brute_force_mismatches = 0;  // NiceDelta disagrees with bruteforce::brute_force_d.
+  uint64_t boundary_cases = 0;          // NiceDelta only agrees with bruteforce::brute_force_d when ticks near the ends of the range are snapped.
+  uint64_t reference_mismatches = 0;    // The table driven constructor disagrees with the reference algorithm.
+  uint64_t batch_mismatches = 0;        // NiceDelta::compute disagrees with the constructor.
+  uint64_t labels = 0;                  // The number of labels compared.
+  uint64_t label_mismatches = 0;        // write_label disagrees with label.
+  Stopwatch nice_delta_timer;
+  Stopwatch reference_timer;
+  Stopwatch batch_timer;
+  Stopwatch brute_force_timer;
+  Stopwatch stream_label_timer;
+  Stopwatch to_chars_label_timer;
+
+  uint64_t mismatches() const
+  {
+    return brute_force_mismatches + reference_mismatches + batch_mismatches + label_mismatches;
+  }
+};
+
+// Only print the first few mismatches of each shard.
+constexpr uint64_t max_reported_mismatches = 10;
+
+void check_shard(std::span<Range<CS::pixels> const> ranges, ShardResult& result)
+{
+  std::size_t const size = ranges.size();
+
+  // Time each algorithm over the whole shard, storing the results for the comparisons below.
+  std::vector<NiceDelta<CS::pixels>> nice_deltas;
+  nice_deltas.reserve(size);
+  result.nice_delta_timer.start();
+  for (Range<CS::pixels> const& range : ranges)
+    nice_deltas.emplace_back(range);
+  result.nice_delta_timer.stop();
+
+  std::vector<NiceDelta<CS::pixels>> references;
+  references.reserve(size);
+  result.reference_timer.start();
+  for (Range<CS::pixels> const& range : ranges)
+    references.emplace_back(range, NiceDelta<CS::pixels>::ReferenceAlgorithm{});
+  result.reference_timer.stop();
+
+  std::vector<int> mantissa(size);
+  std::vector<int> exponent(size);
+  std::vector<int> m(size);
+  result.batch_timer.start();
+  NiceDelta<CS::pixels>::compute(ranges, mantissa, exponent, m);
+  result.batch_timer.stop();
+
+  std::vector<double> d_bf(size);
+  std::vector<int> m_bf(size);
+  result.brute_force_timer.start();
+  for (std::size_t i = 0; i < size; ++i)
+    d_bf[i] = bruteforce::brute_force_d(ranges[i].min(), ranges[i].max(), m_bf[i]);
+  result.brute_force_timer.stop();
+
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    NiceDelta<CS::pixels> const& nice_delta = nice_deltas[i];
+
+    auto agrees = [&](int m, double d) { return m == nice_delta.m() && utils::almost_equal(d, nice_delta.value(), 10e-8); };
+    if (!agrees(m_bf[i], d_bf[i]))
+    {
+      // Accept the result if it is correct once ticks that lie within rounding distance of min or max are counted as on them.
+      int m_snapped;
+      double const d_snapped = bruteforce::brute_force_d(ranges[i].min(), ranges[i].max(), m_snapped, true);
+      if (agrees(m_snapped, d_snapped))
+        ++result.boundary_cases;
+      else if (result.brute_force_mismatches++ < max_reported_mismatches)
+        Dout(dc::warning, ranges[i] << " : d_bf = " << d_bf[i] << ", d = " << nice_delta.value() << ", m_bf = " << m_bf[i] << ", m = " << nice_delta.m());
+    }
+
+    // The values must be bit-identical too, not just mantissa, exponent and m.
+    if (!(nice_delta == references[i]) || nice_delta.value() != references[i].value())
+    {
+      if (result.reference_mismatches++ < max_reported_mismatches)
+        Dout(dc::warning, ranges[i] << " : table = " << nice_delta << ", reference = " << references[i]);
+    }
+
+    if (mantissa[i] != nice_delta.mantissa_index() || exponent[i] != nice_delta.exponent() || m[i] != nice_delta.m())
     {
-      // Given the range: R = [min, max].
-      double max = min + max_minus_min;
+      if (result.batch_mismatches++ < max_reported_mismatches)
+        Dout(dc::warning, ranges[i] << " : batch = {" << mantissa[i] << ", " << exponent[i] << ", " << m[i] << "}, scalar = " << nice_delta);
+    }
+  }
 
-      int m_bf;
-      double d_bf = bruteforce::brute_force_d(min, max, m_bf);
+  // Compare write_label with the std::ostringstream based label for every tick of every tenth range (the stream is slow).
+  std::vector<std::pair<NiceDelta<CS::pixels>, int>> ticks;
+  for (std::size_t i = 0; i < size; i += 10)
+  {
+    NiceDelta<CS::pixels> const& nice_delta = nice_deltas[i];
+    int const k_first = std::ceil(ranges[i].min() / nice_delta.value());
+    for (int k = k_first; k < k_first + nice_delta.m(); ++k)
+      ticks.emplace_back(nice_delta, k);
+  }
+  result.labels = ticks.size();
 
-      NiceDelta nice_delta(Range<CS::pixels>{min, max});
-      int m = nice_delta.m();
-      double d = nice_delta.value();
+  std::vector<std::string> stream_labels(ticks.size());
+  result.stream_label_timer.start();
+  for (std::size_t i = 0; i < ticks.size(); ++i)
+    stream_labels[i] = ticks[i].first.label(ticks[i].second);
+  result.stream_label_timer.stop();
 
-      if (m_bf != m)
-        Dout(dc::warning, "R = [" << min << ", " << max << "] : d_bf = " << d_bf << ", d = " << d << ", m_bf = " << m_bf << ", m = " << m);
-      else
-        ASSERT(utils::almost_equal(d_bf, d, 10e-8));
+  std::vector<NiceDelta<CS::pixels>::Label> to_chars_labels(ticks.size());
+  result.to_chars_label_timer.start();
+  for (std::size_t i = 0; i < ticks.size(); ++i)
+    to_chars_labels[i] = ticks[i].first.fixed_capacity_label(ticks[i].second);
+  result.to_chars_label_timer.stop();
 
-      ASSERT(m_bf == m && utils::almost_equal(d_bf, d, 10e-8));
+  for (std::size_t i = 0; i < ticks.size(); ++i)
+    if (to_chars_labels[i].view() != stream_labels[i])
+    {
+      if (result.label_mismatches++ < max_reported_mismatches)
+        Dout(dc::warning, ticks[i].first << ", k = " << ticks[i].second << " : \"" << to_chars_labels[i].view() << "\" != \"" << stream_labels[i] << "\"");
     }
+}
+
+// Check all ranges, split in one shard per thread; returns the sum of the results of all shards.
+ShardResult check_all(std::vector<Range<CS::pixels>> const& ranges, unsigned int number_of_threads)
+{
+  std::vector<ShardResult> results(number_of_threads);
+  std::vector<std::thread> threads;
+  std::size_t const shard_size = (ranges.size() + number_of_threads - 1) / number_of_threads;
+  for (unsigned int t = 0; t < number_of_threads; ++t)
+  {
+    std::size_t const begin = std::min(ranges.size(), t * shard_size);
+    std::size_t const end = std::min(ranges.size(), begin + shard_size);
+    threads.emplace_back(check_shard, std::span<Range<CS::pixels> const>(ranges).subspan(begin, end - begin), std::ref(results[t]));
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  ShardResult total;
+  for (ShardResult const& result : results)
+  {
+    total.brute_force_mismatches += result.brute_force_mismatches;
+    total.boundary_cases += result.boundary_cases;
+    total.reference_mismatches += result.reference_mismatches;
+    total.batch_mismatches += result.batch_mismatches;
+    total.labels += result.labels;
+    total.label_mismatches += result.label_mismatches;
+    total.nice_delta_timer.add(result.nice_delta_timer);
+    total.reference_timer.add(result.reference_timer);
+    total.batch_timer.add(result.batch_timer);
+    total.brute_force_timer.add(result.brute_force_timer);
+    total.stream_label_timer.add(result.stream_label_timer);
+    total.to_chars_label_timer.add(result.to_chars_label_timer);
+  }
+  return total;
+}
+
+void report(char const* name, std::size_t number_of_ranges, ShardResult const& result, double wall_seconds)
+{
+  std::cout << name << ": " << number_of_ranges << " ranges in " << wall_seconds << " s.\n";
+  std::cout << "  mismatches: brute force: " << result.brute_force_mismatches << ", reference: " << result.reference_mismatches <<
+    ", batch: " << result.batch_mismatches << ", labels: " << result.label_mismatches << " (of " << result.labels << ")\n";
+  std::cout << "  ticks within rounding distance of the range ends: " << result.boundary_cases << "\n";
+  // The timers add up the time of all threads, so these are the costs per range of a single core.
+  std::cout << "  NiceDelta (table):      " << result.nice_delta_timer.ns_per(number_of_ranges) << " ns/range\n";
+  std::cout << "  NiceDelta (reference):  " << result.reference_timer.ns_per(number_of_ranges) << " ns/range\n";
+  std::cout << "  NiceDelta::compute:     " << result.batch_timer.ns_per(number_of_ranges) << " ns/range\n";
+  std::cout << "  brute force:            " << result.brute_force_timer.ns_per(number_of_ranges) << " ns/range\n";
+  std::cout << "  label (ostringstream):  " << result.stream_label_timer.ns_per(result.labels) << " ns/label\n";
+  std::cout << "  write_label (to_chars): " << result.to_chars_label_timer.ns_per(result.labels) << " ns/label\n";
+}
+
+// Usage: NiceDelta_test [number_of_random_ranges [seed [number_of_threads]]]
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  std::size_t const number_of_random_ranges = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  uint64_t const seed = argc > 2 ? std::stoull(argv[2]) : 1234;
+  unsigned int const number_of_threads = argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+  std::cout << "Using " << number_of_threads << " threads.\n";
+
+  uint64_t mismatches = 0;
+  for (bool random : { false, true })
+  {
+    std::vector<Range<CS::pixels>> const ranges = random ? random_ranges(number_of_random_ranges, seed) : grid_ranges();
+    Stopwatch wall_clock;
+    wall_clock.start();
+    ShardResult const result = check_all(ranges, number_of_threads);
+    wall_clock.stop();
+    report(random ? "Random" : "Grid", ranges.size(), result, wall_clock.elapsed_seconds());
+    mismatches += result.mismatches();
+  }
+
+  if (mismatches > 0)
+  {
+    std::cout << "FAILURE: " << mismatches << " mismatches.\n";
+    return EXIT_FAILURE;
+  }
 
   Dout(dc::notice, "Success!");
 }
@@ -0,0 +1,113 @@
+#include "sys.h"
+#include "OffscreenRenderer.h"
+#include "utils/AIAlert.h"
+#ifdef CAIRO_HAS_SVG_SURFACE
+#include <cairo/cairo-svg.h>
+#endif
+#include "debug.h"
+
+OffscreenRenderer::OffscreenRenderer(Format format, int width, int height) : format_(format), width_(width), height_(height)
+{
+  DoutEntering(dc::notice, "OffscreenRenderer::OffscreenRenderer(" << static_cast<int>(format) << ", " << width << ", " << height << ")");
+#ifndef CAIRO_HAS_SVG_SURFACE
+  if (format_ == Format::svg)
+    THROW_ALERT("This cairo library was built without SVG support.");
+#endif
+  if (format_ != Format::svg)
+    surface_ = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width_, height_);
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+  if (cr_)
+    cairo_destroy(cr_);
+  if (surface_)
+    cairo_surface_destroy(surface_);
+}
+
+void OffscreenRenderer::begin_frame(std::string const& filename, cairowindow::Color const& background)
+{
+  // Call end_frame first.
+  ASSERT(!cr_);
+
+#ifdef CAIRO_HAS_SVG_SURFACE
+  if (format_ == Format::svg)
+    surface_ = cairo_svg_surface_create(filename.c_str(), width_, height_);
+#endif
+  filename_ = filename;
+  cr_ = cairo_create(surface_);
+
+  cairo_set_source_rgba(cr_, background.red(), background.green(), background.blue(), background.alpha());
+  cairo_paint(cr_);
+  cairo_set_font_size(cr_, font_size);
+}
+
+void OffscreenRenderer::end_frame()
+{
+  // Call begin_frame first.
+  ASSERT(cr_);
+
+  cairo_destroy(cr_);
+  cr_ = nullptr;
+
+  if (format_ == Format::png)
+  {
+    cairo_surface_flush(surface_);
+    if (cairo_surface_write_to_png(surface_, filename_.c_str()) != CAIRO_STATUS_SUCCESS)
+      THROW_ALERT("Failed to write [FILENAME].", AIArgs("[FILENAME]", filename_));
+  }
+  else if (format_ == Format::svg)
+  {
+    // This writes the file.
+    cairo_surface_finish(surface_);
+    cairo_surface_destroy(surface_);
+    surface_ = nullptr;
+  }
+}
+
+void OffscreenRenderer::draw_line(Point<CS::pixels> const& from, Point<CS::pixels> const& to, cairowindow::draw::LineStyle const& line_style)
+{
+  cairowindow::Color const color = line_style.line_color();
+  cairo_set_source_rgba(cr_, color.red(), color.green(), color.blue(), color.alpha());
+  cairo_set_line_width(cr_, line_style.line_width());
+  cairo_move_to(cr_, from.x(), from.y());
+  cairo_line_to(cr_, to.x(), to.y());
+  cairo_stroke(cr_);
+}
+
+void OffscreenRenderer::draw_text(std::string const& text, Point<CS::pixels> const& anchor, cairowindow::draw::TextPosition position,
+    double rotation, cairowindow::Color const& color)
+{
+  cairo_save(cr_);
+  cairo_translate(cr_, anchor.x(), anchor.y());
+  cairo_rotate(cr_, rotation);
+
+  cairo_text_extents_t extents;
+  cairo_text_extents(cr_, text.c_str(), &extents);
+
+  // Put the text (its ink rectangle) on the side of the anchor given by position.
+  double x = -extents.x_bearing - 0.5 * extents.width;
+  double y = -extents.y_bearing - 0.5 * extents.height;
+  switch (position)
+  {
+    case cairowindow::draw::centered_above:
+      y = -extents.y_bearing - extents.height;
+      break;
+    case cairowindow::draw::centered_below:
+      y = -extents.y_bearing;
+      break;
+    case cairowindow::draw::centered_left_of:
+      x = -extents.x_bearing - extents.width;
+      break;
+    case cairowindow::draw::centered_right_of:
+      x = -extents.x_bearing;
+      break;
+    default:
+      break;
+  }
+
+  cairo_set_source_rgba(cr_, color.red(), color.green(), color.blue(), color.alpha());
+  cairo_move_to(cr_, x, y);
+  cairo_show_text(cr_, text.c_str());
+  cairo_restore(cr_);
+}
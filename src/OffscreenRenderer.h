@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoordinateSystem.h"
+#include "Point.h"
+#include "cairowindow/Color.h"
+#include "cairowindow/draw/Line.h"
+#include "cairowindow/draw/Text.h"
+#include <cairo/cairo.h>
+#include <string>
+
+// Render CoordinateSystem drawings (and loose lines) without a window: to an in-memory image, or to PNG or SVG files.
+//
+// Usage:
+//
+//   OffscreenRenderer renderer(OffscreenRenderer::Format::png, window_width, window_height);
+//   renderer.begin_frame("frame.png", color::white);
+//   renderer.draw(coordinate_system);
+//   renderer.end_frame();                      // Writes frame.png.
+//
+class OffscreenRenderer
+{
+ public:
+  enum class Format
+  {
+    image,      // Only render to an in-memory image surface (see surface()); nothing is written.
+    png,        // Render to an image surface and write it to a PNG file at the end of each frame.
+    svg         // Render each frame straight to its own SVG file.
+  };
+
+  static constexpr double font_size = 12.0;
+
+ private:
+  Format format_;
+  int width_;
+  int height_;
+  cairo_surface_t* surface_ = nullptr;  // For image and png: created once and reused by every frame. For svg: one per frame.
+  cairo_t* cr_ = nullptr;               // Only valid between begin_frame and end_frame.
+  std::string filename_;                // The file that end_frame writes (png only).
+
+ public:
+  OffscreenRenderer(Format format, int width, int height);
+  ~OffscreenRenderer();
+
+  OffscreenRenderer(OffscreenRenderer const&) = delete;
+  OffscreenRenderer& operator=(OffscreenRenderer const&) = delete;
+
+  // Start a new frame, filled with background. The filename is ignored for Format::image.
+  void begin_frame(std::string const& filename, cairowindow::Color const& background);
+  // Finish the frame; this writes the PNG file, or closes the SVG file.
+  void end_frame();
+
+  void draw_line(Point<CS::pixels> const& from, Point<CS::pixels> const& to, cairowindow::draw::LineStyle const& line_style);
+  void draw_text(std::string const& text, Point<CS::pixels> const& anchor, cairowindow::draw::TextPosition position, double rotation,
+      cairowindow::Color const& color);
+
+  // Draw the lines and labels of the last layout of coordinate_system.
+  template<CS cs>
+  void draw(draw::CoordinateSystem<cs> const& coordinate_system)
+  {
+    for (auto const& line : coordinate_system.line_geometry())
+      draw_line(line.from, line.to, coordinate_system.axis_style());
+    for (auto const& text : coordinate_system.text_geometry())
+      draw_text(text.label, text.anchor, text.position, text.rotation, coordinate_system.axis_style().line_color());
+  }
+
+  // The image surface of the last frame (Format::image and Format::png only).
+  cairo_surface_t* surface() const { return surface_; }
+};
@@ -3,21 +3,44 @@
 #include "CS.h"
 #include "Size.h"
 #include "cairowindow/Point.h"
+#include <type_traits>
 
+// A point in coordinate system cs.
+//
+// The coordinates are stored directly, rather than by deriving from cairowindow::Point, so that
+// the type is trivially copyable (arrays of points can be memcpy-ed and kept in registers) and
+// can be used in constant expressions. It converts implicitly to a cairowindow::Point, which
+// has no coordinate system, but converting back must be done explicitly.
 template<CS cs>
-class Point : public cairowindow::Point
+class Point
 {
+ private:
+  double x_;
+  double y_;
+
  public:
   // Construct the origin.
-  Point() : cairowindow::Point(0.0, 0.0) { }
-  Point(double x, double y) : cairowindow::Point(x, y) { }
+  constexpr Point() : x_(0.0), y_(0.0) { }
+  constexpr Point(double x, double y) : x_(x), y_(y) { }
+
+  // Adopt the coordinates of a point that was calculated by cairowindow.
+  explicit Point(cairowindow::Point const& point) : x_(point.x()), y_(point.y()) { }
 
-  // Allow returning a cairowindow::Point by value from a function that returns a Point<cs>.
-  // This constructor should never be called manually (i.e. using std::move).
-  Point(cairowindow::Point&& base) : cairowindow::Point(base) { }
+  constexpr double x() const { return x_; }
+  constexpr double y() const { return y_; }
 
-  Point operator+(Size<cs> const& size) const
+  operator cairowindow::Point() const { return {x_, y_}; }
+
+  constexpr Point operator+(Size<cs> const& size) const
   {
-    return {x() + size.width(), y() + size.height()};
+    return {x_ + size.width(), y_ + size.height()};
+  }
+
+  void print_on(std::ostream& os) const
+  {
+    os << utils::to_string(cs) << ":(" << x_ << ", " << y_ << ")";
   }
 };
+
+static_assert(std::is_trivially_copyable_v<Point<CS::pixels>>);
+static_assert(Point<CS::pixels>{1.0, 2.0}.y() == 2.0, "Point must be constexpr constructible.");
@@ -0,0 +1,410 @@
+#pragma once
+
+#include "Transform.h"
+#include "Vector.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+
+// Bulk storage for points and vectors of one coordinate system, in structure-of-arrays layout:
+// all x coordinates are contiguous, and so are all y coordinates. Compared to std::vector<Point<cs>>
+// this lets a whole data set be mapped through a Transform (or combined element-wise) by the SIMD
+// kernels, while the CS template parameter keeps the compile-time coordinate-system checks:
+//
+//   PointArray<CS::painter> points = ...;
+//   PointArray<CS::pixels> pixels = points * painter_transform_pixels;    // Only compiles if the transform starts at CS::painter.
+//
+// Elements are copied in and out by value; use x() and y() for direct access to the coordinate arrays.
+
+namespace detail {
+
+// The x and y arrays are aligned on a 32 byte boundary, the size of an AVX register.
+constexpr std::size_t point_array_alignment = 32;
+
+template<typename T>
+struct AlignedAllocator
+{
+  using value_type = T;
+
+  AlignedAllocator() = default;
+  template<typename U>
+  AlignedAllocator(AlignedAllocator<U> const&) { }
+
+  T* allocate(std::size_t n)
+  {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{point_array_alignment}));
+  }
+
+  void deallocate(T* p, std::size_t)
+  {
+    ::operator delete(p, std::align_val_t{point_array_alignment});
+  }
+
+  template<typename U>
+  friend bool operator==(AlignedAllocator const&, AlignedAllocator<U> const&) { return true; }
+};
+
+using aligned_doubles = std::vector<double, AlignedAllocator<double>>;
+
+// The coordinate arrays of a PointArray or VectorArray.
+class CoordinateArrays
+{
+ protected:
+  aligned_doubles x_;
+  aligned_doubles y_;
+
+  CoordinateArrays() = default;
+  explicit CoordinateArrays(std::size_t n) : x_(n), y_(n) { }
+  CoordinateArrays(aligned_doubles&& x, aligned_doubles&& y) : x_(std::move(x)), y_(std::move(y)) { }
+
+  // Return pointers that the compiler may assume to be aligned, so that it can vectorize the loops that use them.
+  double* x_data() { return std::assume_aligned<point_array_alignment>(x_.data()); }
+  double* y_data() { return std::assume_aligned<point_array_alignment>(y_.data()); }
+  double const* x_data() const { return std::assume_aligned<point_array_alignment>(x_.data()); }
+  double const* y_data() const { return std::assume_aligned<point_array_alignment>(y_.data()); }
+
+ public:
+  std::size_t size() const { return x_.size(); }
+  bool empty() const { return x_.empty(); }
+
+  void reserve(std::size_t n) { x_.reserve(n); y_.reserve(n); }
+  void resize(std::size_t n) { x_.resize(n); y_.resize(n); }
+  void clear() { x_.clear(); y_.clear(); }
+
+  std::span<double> x() { return x_; }
+  std::span<double> y() { return y_; }
+  std::span<double const> x() const { return x_; }
+  std::span<double const> y() const { return y_; }
+};
+
+} // namespace detail
+
+template<CS cs>
+class VectorArray;
+
+template<CS cs>
+class PointArray : public detail::CoordinateArrays
+{
+ private:
+  template<CS cs2>
+  friend class PointArray;
+
+  PointArray(detail::aligned_doubles&& x, detail::aligned_doubles&& y) : CoordinateArrays(std::move(x), std::move(y)) { }
+
+ public:
+  // Construct an empty array.
+  PointArray() = default;
+
+  // Construct an array of n points at the origin.
+  explicit PointArray(std::size_t n) : CoordinateArrays(n) { }
+
+  // Construct an array from points stored in AoS layout.
+  explicit PointArray(std::span<Point<cs> const> points) : CoordinateArrays(points.size())
+  {
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+      x_[i] = points[i].x();
+      y_[i] = points[i].y();
+    }
+  }
+
+  // The coordinate arrays, tagged with the coordinate system (for Transform::map).
+  SoAView<cs> view() const { return {x_, y_}; }
+  SoAView<cs, double> view() { return {x_, y_}; }
+
+  Point<cs> operator[](std::size_t i) const { return {x_[i], y_[i]}; }
+  void set(std::size_t i, Point<cs> const& point) { x_[i] = point.x(); y_[i] = point.y(); }
+
+  void push_back(Point<cs> const& point)
+  {
+    x_.push_back(point.x());
+    y_.push_back(point.y());
+  }
+
+  // Translate all points over v.
+  PointArray& operator+=(Vector<cs> const& v);
+  PointArray& operator-=(Vector<cs> const& v) { return *this += Vector<cs>{-v.x(), -v.y()}; }
+
+  // Translate point i over vectors[i], for every i.
+  PointArray& operator+=(VectorArray<cs> const& vectors);
+
+  // Map all points to to_cs. An rvalue array reuses its storage for the result.
+  template<CS to_cs, bool inverted>
+  PointArray<to_cs> transformed(Transform<cs, to_cs, inverted> const& transform) const&;
+  template<CS to_cs, bool inverted>
+  PointArray<to_cs> transformed(Transform<cs, to_cs, inverted> const& transform) &&;
+  template<CS to_cs, typename... Links>
+  PointArray<to_cs> transformed(TransformChain<cs, to_cs, Links...> const& chain) const&;
+  template<CS to_cs, typename... Links>
+  PointArray<to_cs> transformed(TransformChain<cs, to_cs, Links...> const& chain) &&;
+};
+
+template<CS cs>
+class VectorArray : public detail::CoordinateArrays
+{
+ private:
+  template<CS cs2>
+  friend class PointArray;
+
+ public:
+  // Construct an empty array.
+  VectorArray() = default;
+
+  // Construct an array of n zero vectors.
+  explicit VectorArray(std::size_t n) : CoordinateArrays(n) { }
+
+  // Construct an array from vectors stored in AoS layout.
+  explicit VectorArray(std::span<Vector<cs> const> vectors) : CoordinateArrays(vectors.size())
+  {
+    for (std::size_t i = 0; i < vectors.size(); ++i)
+    {
+      x_[i] = vectors[i].x();
+      y_[i] = vectors[i].y();
+    }
+  }
+
+  Vector<cs> operator[](std::size_t i) const { return {x_[i], y_[i]}; }
+  void set(std::size_t i, Vector<cs> const& vector) { x_[i] = vector.x(); y_[i] = vector.y(); }
+
+  void push_back(Vector<cs> const& vector)
+  {
+    x_.push_back(vector.x());
+    y_.push_back(vector.y());
+  }
+
+  // Element-wise versions of Vector::dot and Vector::cross; the results are written to out,
+  // which must have the same size as this array.
+  void dot(VectorArray const& v2, std::span<double> out) const;
+  void dot(Vector<cs> const& v2, std::span<double> out) const;
+  void cross(VectorArray const& v2, std::span<double> out) const;
+  void cross(Vector<cs> const& v2, std::span<double> out) const;
+
+  // Return every vector rotated 90 degrees counter-clockwise, like Vector::rotate_90_degrees.
+  VectorArray rotate_90_degrees() const;
+
+  VectorArray& operator*=(double scalar);
+};
+
+template<CS cs>
+PointArray<cs>& PointArray<cs>::operator+=(Vector<cs> const& v)
+{
+  double const vx = v.x();
+  double const vy = v.y();
+  double* x = x_data();
+  double* y = y_data();
+  std::size_t const n = size();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    x[i] += vx;
+    y[i] += vy;
+  }
+  return *this;
+}
+
+template<CS cs>
+PointArray<cs>& PointArray<cs>::operator+=(VectorArray<cs> const& vectors)
+{
+  ASSERT(vectors.size() == size());
+  double* __restrict x = x_data();
+  double* __restrict y = y_data();
+  double const* __restrict vx = vectors.x_data();
+  double const* __restrict vy = vectors.y_data();
+  std::size_t const n = size();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    x[i] += vx[i];
+    y[i] += vy[i];
+  }
+  return *this;
+}
+
+template<CS cs>
+template<CS to_cs, bool inverted>
+PointArray<to_cs> PointArray<cs>::transformed(Transform<cs, to_cs, inverted> const& transform) const&
+{
+  PointArray<to_cs> result(size());
+  transform.map(view(), result.view());
+  return result;
+}
+
+template<CS cs>
+template<CS to_cs, bool inverted>
+PointArray<to_cs> PointArray<cs>::transformed(Transform<cs, to_cs, inverted> const& transform) &&
+{
+  // The kernel may write its output over its input; the storage holds points of to_cs afterwards.
+  affine_map(transform.matrix().coefficients(), x_data(), y_data(), x_data(), y_data(), size());
+  return {std::move(x_), std::move(y_)};
+}
+
+template<CS cs>
+template<CS to_cs, typename... Links>
+PointArray<to_cs> PointArray<cs>::transformed(TransformChain<cs, to_cs, Links...> const& chain) const&
+{
+  PointArray<to_cs> result(size());
+  chain.map(view(), result.view());
+  return result;
+}
+
+template<CS cs>
+template<CS to_cs, typename... Links>
+PointArray<to_cs> PointArray<cs>::transformed(TransformChain<cs, to_cs, Links...> const& chain) &&
+{
+  affine_map(chain.forward().coefficients(), x_data(), y_data(), x_data(), y_data(), size());
+  return {std::move(x_), std::move(y_)};
+}
+
+template<CS cs>
+void VectorArray<cs>::dot(VectorArray const& v2, std::span<double> out) const
+{
+  ASSERT(v2.size() == size() && out.size() == size());
+  double const* __restrict x1 = x_data();
+  double const* __restrict y1 = y_data();
+  double const* __restrict x2 = v2.x_data();
+  double const* __restrict y2 = v2.y_data();
+  double* __restrict result = out.data();
+  std::size_t const n = size();
+  for (std::size_t i = 0; i < n; ++i)
+    result[i] = x1[i] * x2[i] + y1[i] * y2[i];
+}
+
+template<CS cs>
+void VectorArray<cs>::dot(Vector<cs> const& v2, std::span<double> out) const
+{
+  ASSERT(out.size() == size());
+  double const x2 = v2.x();
+  double const y2 = v2.y();
+  double const* __restrict x1 = x_data();
+  double const* __restrict y1 = y_data();
+  double* __restrict result = out.data();
+  std::size_t const n = size();
+  for (std::size_t i = 0; i < n; ++i)
+    result[i] = x1[i] * x2 + y1[i] * y2;
+}
+
+template<CS cs>
+void VectorArray<cs>::cross(VectorArray const& v2, std::span<double> out) const
+{
+  ASSERT(v2.size() == size() && out.size() == size());
+  double const* __restrict x1 = x_data();
+  double const* __restrict y1 = y_data();
+  double const* __restrict x2 = v2.x_data();
+  double const* __restrict y2 = v2.y_data();
+  double* __restrict result = out.data();
+  std::size_t const n = size();
+  for (std::size_t i = 0; i < n; ++i)
+    result[i] = x1[i] * y2[i] - y1[i] * x2[i];
+}
+
+template<CS cs>
+void VectorArray<cs>::cross(Vector<cs> const& v2, std::span<double> out) const
+{
+  ASSERT(out.size() == size());
+  double const x2 = v2.x();
+  double const y2 = v2.y();
+  double const* __restrict x1 = x_data();
+  double const* __restrict y1 = y_data();
+  double* __restrict result = out.data();
+  std::size_t const n = size();
+  for (std::size_t i = 0; i < n; ++i)
+    result[i] = x1[i] * y2 - y1[i] * x2;
+}
+
+template<CS cs>
+VectorArray<cs> VectorArray<cs>::rotate_90_degrees() const
+{
+  // (x, y) --> (-y, x): a copy of y (negated) and a copy of x.
+  VectorArray result(size());
+  double const* __restrict y = y_data();
+  double* __restrict result_x = result.x_data();
+  std::size_t const n = size();
+  for (std::size_t i = 0; i < n; ++i)
+    result_x[i] = -y[i];
+  result.y_ = x_;
+  return result;
+}
+
+template<CS cs>
+VectorArray<cs>& VectorArray<cs>::operator*=(double scalar)
+{
+  double* x = x_data();
+  double* y = y_data();
+  std::size_t const n = size();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    x[i] *= scalar;
+    y[i] *= scalar;
+  }
+  return *this;
+}
+
+// The difference between two points is a vector.
+template<CS cs>
+VectorArray<cs> operator-(PointArray<cs> const& to, PointArray<cs> const& from)
+{
+  ASSERT(to.size() == from.size());
+  VectorArray<cs> result(to.size());
+  std::span<double> result_x = result.x();
+  std::span<double> result_y = result.y();
+  for (std::size_t i = 0; i < to.size(); ++i)
+  {
+    result_x[i] = to.x()[i] - from.x()[i];
+    result_y[i] = to.y()[i] - from.y()[i];
+  }
+  return result;
+}
+
+template<CS cs>
+PointArray<cs> operator+(PointArray<cs> points, Vector<cs> const& v)
+{
+  points += v;
+  return points;
+}
+
+template<CS cs>
+PointArray<cs> operator+(PointArray<cs> points, VectorArray<cs> const& vectors)
+{
+  points += vectors;
+  return points;
+}
+
+// Map points through transform into out, which is resized if needed. Use this to reuse the storage of out
+// when the same data set is mapped repeatedly.
+template<CS from_cs, CS to_cs, bool inverted>
+void map(PointArray<from_cs> const& points, Transform<from_cs, to_cs, inverted> const& transform, PointArray<to_cs>& out)
+{
+  out.resize(points.size());
+  transform.map(points.view(), out.view());
+}
+
+template<CS from_cs, CS to_cs, typename... Links>
+void map(PointArray<from_cs> const& points, TransformChain<from_cs, to_cs, Links...> const& chain, PointArray<to_cs>& out)
+{
+  out.resize(points.size());
+  chain.map(points.view(), out.view());
+}
+
+template<CS from_cs, CS to_cs, bool inverted>
+PointArray<to_cs> operator*(PointArray<from_cs> const& points, Transform<from_cs, to_cs, inverted> const& transform)
+{
+  return points.transformed(transform);
+}
+
+template<CS from_cs, CS to_cs, bool inverted>
+PointArray<to_cs> operator*(PointArray<from_cs>&& points, Transform<from_cs, to_cs, inverted> const& transform)
+{
+  return std::move(points).transformed(transform);
+}
+
+template<CS from_cs, CS to_cs, typename... Links>
+PointArray<to_cs> operator*(PointArray<from_cs> const& points, TransformChain<from_cs, to_cs, Links...> const& chain)
+{
+  return points.transformed(chain);
+}
+
+template<CS from_cs, CS to_cs, typename... Links>
+PointArray<to_cs> operator*(PointArray<from_cs>&& points, TransformChain<from_cs, to_cs, Links...> const& chain)
+{
+  return std::move(points).transformed(chain);
+}
@@ -0,0 +1,157 @@
+#include "sys.h"
+#include "PointArray.h"
+#include "Stopwatch.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "debug.h"
+
+// Check PointArray and VectorArray against the single-object Point and Vector operations,
+// and time mapping a large data set through a Transform in both layouts.
+//
+// Usage: PointArray_test [number_of_points]
+
+namespace {
+
+// Mapping an array through a Transform only compiles if the transform starts in the coordinate system of the array.
+template<typename Array, typename T>
+concept Mappable = requires(Array const& array, T const& transform) { array * transform; };
+
+static_assert(Mappable<PointArray<CS::centered>, Transform<CS::centered, CS::pixels>>);
+static_assert(!Mappable<PointArray<CS::pixels>, Transform<CS::centered, CS::pixels>>);
+static_assert(Mappable<PointArray<CS::pixels>, Transform<CS::pixels, CS::centered, true>>);
+
+// The same for Transform::map of coordinate arrays: raw doubles are not accepted, only views with the right CS.
+template<typename T, typename In, typename Out>
+concept MapsArrays = requires(T const& transform, In in, Out out) { transform.map(in, out); };
+
+using CenteredTransformPixels = Transform<CS::centered, CS::pixels>;
+static_assert(MapsArrays<CenteredTransformPixels, SoAView<CS::centered>, SoAView<CS::pixels, double>>);
+static_assert(MapsArrays<CenteredTransformPixels, SoAView<CS::centered, double>, SoAView<CS::pixels, double>>);
+static_assert(!MapsArrays<CenteredTransformPixels, SoAView<CS::pixels>, SoAView<CS::pixels, double>>);
+static_assert(!MapsArrays<CenteredTransformPixels, SoAView<CS::centered>, SoAView<CS::centered, double>>);
+static_assert(!MapsArrays<CenteredTransformPixels, SoAView<CS::centered>, SoAView<CS::pixels>>);
+static_assert(!MapsArrays<CenteredTransformPixels, std::span<double const>, std::span<double>>);
+
+int failures = 0;
+
+void check(bool ok, std::string const& what, std::size_t i)
+{
+  if (!ok && failures++ < 10)
+    std::cerr << what << " differs at index " << i << std::endl;
+}
+
+// The SIMD kernels may use fused multiply-add; allow for a difference in the last few bits.
+bool close(double a, double b)
+{
+  return std::abs(a - b) <= 1e-12 * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  std::size_t const number_of_points = argc > 1 ? std::stoul(argv[1]) : 1000003;       // Not a multiple of the SIMD width.
+
+  Transform<CS::centered, CS::pixels> const centered_transform_pixels =
+    Transform<CS::centered, CS::pixels>{}.translate(half_window_size).scale(half_window_size.height()).rotate(30.0);
+  auto const& pixels_transform_centered = centered_transform_pixels.inverse();
+
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  std::vector<Point<CS::centered>> points;
+  std::vector<Vector<CS::centered>> vectors;
+  points.reserve(number_of_points);
+  vectors.reserve(number_of_points);
+  for (std::size_t i = 0; i < number_of_points; ++i)
+  {
+    points.emplace_back(distribution(engine), distribution(engine));
+    vectors.emplace_back(distribution(engine), distribution(engine));
+  }
+
+  PointArray<CS::centered> const point_array(points);
+  VectorArray<CS::centered> const vector_array(vectors);
+  Vector<CS::centered> const v(0.25, -0.75);
+
+  // Transform; first a copy, then the round trip back, reusing the storage.
+  PointArray<CS::pixels> const pixels = point_array * centered_transform_pixels;
+  PointArray<CS::centered> const round_trip = PointArray<CS::pixels>{pixels} * pixels_transform_centered;
+  for (std::size_t i = 0; i < number_of_points; ++i)
+  {
+    Point<CS::pixels> const expected = points[i] * centered_transform_pixels;
+    check(close(pixels[i].x(), expected.x()) && close(pixels[i].y(), expected.y()), "operator*(PointArray, Transform)", i);
+    check(close(round_trip[i].x(), points[i].x()) && close(round_trip[i].y(), points[i].y()), "Round trip", i);
+  }
+
+  // Dot and cross products.
+  std::vector<double> dot(number_of_points);
+  std::vector<double> dot_v(number_of_points);
+  std::vector<double> cross(number_of_points);
+  std::vector<double> cross_v(number_of_points);
+  VectorArray<CS::centered> const swapped = vector_array.rotate_90_degrees();
+  vector_array.dot(swapped, dot);
+  vector_array.dot(v, dot_v);
+  vector_array.cross(swapped, cross);
+  vector_array.cross(v, cross_v);
+  for (std::size_t i = 0; i < number_of_points; ++i)
+  {
+    Vector<CS::centered> const rotated = vectors[i].rotate_90_degrees();
+    check(swapped[i].x() == rotated.x() && swapped[i].y() == rotated.y(), "rotate_90_degrees", i);
+    check(close(dot[i], vectors[i].dot(rotated)), "dot(VectorArray)", i);
+    check(close(dot_v[i], vectors[i].dot(v)), "dot(Vector)", i);
+    check(close(cross[i], vectors[i].cross(rotated)), "cross(VectorArray)", i);
+    check(close(cross_v[i], vectors[i].cross(v)), "cross(Vector)", i);
+  }
+
+  // Translations.
+  PointArray<CS::centered> const translated = point_array + v;
+  PointArray<CS::centered> const moved = point_array + vector_array;
+  VectorArray<CS::centered> const difference = moved - point_array;
+  for (std::size_t i = 0; i < number_of_points; ++i)
+  {
+    Point<CS::centered> const expected = points[i] + v;
+    check(translated[i].x() == expected.x() && translated[i].y() == expected.y(), "operator+(PointArray, Vector)", i);
+    Point<CS::centered> const expected_moved = points[i] + vectors[i];
+    check(moved[i].x() == expected_moved.x() && moved[i].y() == expected_moved.y(), "operator+(PointArray, VectorArray)", i);
+    check(close(difference[i].x(), vectors[i].x()) && close(difference[i].y(), vectors[i].y()), "operator-(PointArray, PointArray)", i);
+  }
+
+  // Timing: AoS (Transform::map of Point objects) versus SoA (PointArray).
+  constexpr int repeat = 10;
+  std::vector<Point<CS::pixels>> mapped_points(number_of_points);
+  PointArray<CS::pixels> mapped_array(number_of_points);
+  Stopwatch aos;
+  Stopwatch soa;
+  Stopwatch soa_new;
+  for (int r = 0; r < repeat; ++r)
+  {
+    aos.start();
+    centered_transform_pixels.map(points, mapped_points);
+    aos.stop();
+    do_not_optimize(mapped_points.back());
+
+    soa.start();
+    map(point_array, centered_transform_pixels, mapped_array);
+    soa.stop();
+    do_not_optimize(mapped_array.x().back());
+
+    soa_new.start();
+    PointArray<CS::pixels> const result = point_array * centered_transform_pixels;
+    soa_new.stop();
+    do_not_optimize(result.x().back());
+  }
+
+  uint64_t const total = uint64_t{number_of_points} * repeat;
+  std::cout << number_of_points << " points; " << failures << " failures." << std::endl;
+  std::cout << "Transform::map (AoS):                  " << aos.ns_per(total) << " ns/point\n";
+  std::cout << "map(PointArray, Transform, out) (SoA): " << soa.ns_per(total) << " ns/point\n";
+  std::cout << "PointArray * Transform (SoA):          " << soa_new.ns_per(total) << " ns/point (includes allocation)\n";
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
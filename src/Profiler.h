@@ -0,0 +1,216 @@
+#pragma once
+
+// Opt-in instrumentation: per-phase scoped timers and event counters.
+//
+// Configure with -DEnableProfiling=ON to define TRANSFORM_PROFILING. Without it every macro below
+// expands to nothing, so instrumented code has no overhead at all.
+//
+//   PROFILE_SCOPE(profiler::Phase::layout);                    // Time the rest of the enclosing scope.
+//   PROFILE_COUNT(profiler::Counter::lines_allocated, 1);      // Add 1 to a counter.
+//   PROFILE_REPORT(std::cout);                                 // Print the aggregated statistics.
+//   PROFILE_RESET();                                           // Start over.
+//
+// Timings are collected in histograms with power-of-two buckets (in nanoseconds); the reported
+// percentiles are the upper bounds of the bucket that contains them, so they are accurate up to a factor of two.
+
+#ifdef TRANSFORM_PROFILING
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+
+namespace profiler {
+
+enum class Phase
+{
+  constructor,          // CoordinateSystem::CoordinateSystem.
+  set_transform,        // CoordinateSystem::set_transform, including update_axes and layout.
+  update_axes,          // Intersecting the axes with the window.
+  nice_delta,           // Constructing the TickHierarchy (NiceDelta) of an axis.
+  layout,               // Calculating the line and text geometry.
+  label_formatting,     // Formatting a tick label that wasn't cached.
+  display,              // CoordinateSystem::display, including prepare and layer_draw.
+  prepare,              // CoordinateSystem::prepare, including allocation.
+  allocation,           // Allocating one draw object.
+  layer_draw,           // Passing one draw object to Layer::draw.
+  number_of_phases
+};
+
+enum class Counter
+{
+  labels_formatted,     // The number of tick labels that were formatted (cache misses).
+  lines_allocated,      // The number of draw::Line objects that were created.
+  texts_allocated,      // The number of draw::Text objects that were created.
+  lines_reused,         // The number of draw::Line objects that were kept from the previous display.
+  texts_reused,         // The number of draw::Text objects that were kept from the previous display.
+  arena_bytes,          // The number of bytes of DrawObjectArena's that were created.
+  number_of_counters
+};
+
+inline char const* name(Phase phase)
+{
+  static constexpr std::array<char const*, static_cast<int>(Phase::number_of_phases)> names = {
+    "constructor", "set_transform", "update_axes", "nice_delta", "layout", "label_formatting", "display", "prepare", "allocation", "layer_draw"
+  };
+  return names[static_cast<int>(phase)];
+}
+
+inline char const* name(Counter counter)
+{
+  static constexpr std::array<char const*, static_cast<int>(Counter::number_of_counters)> names = {
+    "labels_formatted", "lines_allocated", "texts_allocated", "lines_reused", "texts_reused", "arena_bytes"
+  };
+  return names[static_cast<int>(counter)];
+}
+
+// A histogram of durations, with one bucket per power of two nanoseconds.
+// Bucket b contains the samples in [2^(b-1), 2^b) ns; bucket 0 contains the samples of 0 ns.
+class Histogram
+{
+ public:
+  static constexpr int number_of_buckets = 65;
+
+ private:
+  std::array<std::atomic<uint64_t>, number_of_buckets> buckets_{};
+  std::atomic<uint64_t> count_{};
+  std::atomic<uint64_t> total_ns_{};
+  std::atomic<uint64_t> max_ns_{};
+
+ public:
+  void add(uint64_t ns)
+  {
+    buckets_[std::bit_width(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+    while (ns > max_ns && !max_ns_.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed))
+      ;
+  }
+
+  void reset()
+  {
+    for (auto& bucket : buckets_)
+      bucket.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    total_ns_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t total_ns() const { return total_ns_.load(std::memory_order_relaxed); }
+  uint64_t max_ns() const { return max_ns_.load(std::memory_order_relaxed); }
+
+  // Return an upper bound of the p-th percentile (0 < p <= 100), in nanoseconds.
+  uint64_t percentile_ns(double p) const
+  {
+    uint64_t const rank = static_cast<uint64_t>(p / 100.0 * count() + 0.5);
+    uint64_t seen = 0;
+    for (int b = 0; b < number_of_buckets; ++b)
+    {
+      seen += buckets_[b].load(std::memory_order_relaxed);
+      if (seen >= rank && seen > 0)
+      {
+        if (b == 0)
+          return 0;
+        if (b == number_of_buckets - 1)
+          return max_ns();
+        return std::min(max_ns(), (uint64_t{1} << b) - 1);
+      }
+    }
+    return max_ns();
+  }
+};
+
+class Profiler
+{
+ private:
+  std::array<Histogram, static_cast<int>(Phase::number_of_phases)> phases_;
+  std::array<std::atomic<uint64_t>, static_cast<int>(Counter::number_of_counters)> counters_{};
+
+ public:
+  static Profiler& instance()
+  {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  void add(Phase phase, uint64_t ns) { phases_[static_cast<int>(phase)].add(ns); }
+  void count(Counter counter, uint64_t n) { counters_[static_cast<int>(counter)].fetch_add(n, std::memory_order_relaxed); }
+
+  void reset()
+  {
+    for (auto& phase : phases_)
+      phase.reset();
+    for (auto& counter : counters_)
+      counter.store(0, std::memory_order_relaxed);
+  }
+
+  void report(std::ostream& os) const
+  {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-18s %10s %12s %10s %10s %10s %10s %10s\n",
+        "phase", "count", "total [us]", "mean [ns]", "p50 [ns]", "p90 [ns]", "p99 [ns]", "max [ns]");
+    os << line;
+    for (int p = 0; p < static_cast<int>(Phase::number_of_phases); ++p)
+    {
+      Histogram const& histogram = phases_[p];
+      if (histogram.count() == 0)
+        continue;
+      std::snprintf(line, sizeof(line), "%-18s %10llu %12.1f %10.0f %10llu %10llu %10llu %10llu\n",
+          name(static_cast<Phase>(p)), static_cast<unsigned long long>(histogram.count()), histogram.total_ns() * 1e-3,
+          static_cast<double>(histogram.total_ns()) / histogram.count(),
+          static_cast<unsigned long long>(histogram.percentile_ns(50)), static_cast<unsigned long long>(histogram.percentile_ns(90)),
+          static_cast<unsigned long long>(histogram.percentile_ns(99)), static_cast<unsigned long long>(histogram.max_ns()));
+      os << line;
+    }
+    for (int c = 0; c < static_cast<int>(Counter::number_of_counters); ++c)
+    {
+      std::snprintf(line, sizeof(line), "%-18s %10llu\n",
+          name(static_cast<Counter>(c)), static_cast<unsigned long long>(counters_[c].load(std::memory_order_relaxed)));
+      os << line;
+    }
+  }
+};
+
+// Add the time between construction and destruction to a phase.
+class ScopedTimer
+{
+ private:
+  using clock_type = std::chrono::steady_clock;
+
+  Phase phase_;
+  clock_type::time_point start_;
+
+ public:
+  explicit ScopedTimer(Phase phase) : phase_(phase), start_(clock_type::now()) { }
+  ~ScopedTimer()
+  {
+    Profiler::instance().add(phase_, std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start_).count());
+  }
+
+  ScopedTimer(ScopedTimer const&) = delete;
+  ScopedTimer& operator=(ScopedTimer const&) = delete;
+};
+
+} // namespace profiler
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(phase) ::profiler::ScopedTimer PROFILE_CONCAT(profile_scope_, __LINE__)(phase)
+#define PROFILE_COUNT(counter, n) ::profiler::Profiler::instance().count(counter, n)
+#define PROFILE_REPORT(os) ::profiler::Profiler::instance().report(os)
+#define PROFILE_RESET() ::profiler::Profiler::instance().reset()
+
+#else // TRANSFORM_PROFILING
+
+#define PROFILE_SCOPE(phase) do { } while (0)
+#define PROFILE_COUNT(counter, n) do { } while (0)
+#define PROFILE_REPORT(os) do { } while (0)
+#define PROFILE_RESET() do { } while (0)
+
+#endif // TRANSFORM_PROFILING
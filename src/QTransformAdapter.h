@@ -0,0 +1,26 @@
+#pragma once
+
+// Conversion between AffineTransform / Transform and QTransform.
+// Only include this header in translation units that are linked with Qt6::Gui.
+
+#include "Transform.h"
+#include <QTransform>
+
+inline QTransform to_qtransform(AffineTransform const& m)
+{
+  return {m.m11(), m.m12(), m.m21(), m.m22(), m.dx(), m.dy()};
+}
+
+// The QTransform must be affine (no projection).
+inline AffineTransform from_qtransform(QTransform const& m)
+{
+  ASSERT(m.isAffine());
+  return {m.m11(), m.m12(), m.m21(), m.m22(), m.dx(), m.dy()};
+}
+
+// Return the QTransform that converts from `from_cs` to `to_cs`.
+template<CS from_cs, CS to_cs, bool inverted>
+QTransform to_qtransform(Transform<from_cs, to_cs, inverted> const& transform)
+{
+  return to_qtransform(transform.matrix());
+}
@@ -3,7 +3,7 @@
 #include "CS.h"
 #include "utils/has_print_on.h"
 #include "utils/to_string.h"
-#include <QPointF>      // For qreal
+#include <type_traits>
 
 constexpr int window_width = 600;
 constexpr int window_height = 450;
@@ -17,14 +17,14 @@ template<CS cs>
 class Size
 {
  private:
-  qreal width_;
-  qreal height_;
+  double width_;
+  double height_;
 
  public:
-  constexpr Size(qreal width, qreal height) : width_(width), height_(height) { }
+  constexpr Size(double width, double height) : width_(width), height_(height) { }
 
-  qreal width() const { return width_; }
-  qreal height() const { return height_; }
+  constexpr double width() const { return width_; }
+  constexpr double height() const { return height_; }
 
   void print_on(std::ostream& os) const
   {
@@ -32,5 +32,7 @@ class Size
   }
 };
 
+static_assert(std::is_trivially_copyable_v<Size<CS::pixels>>);
+
 static constexpr Size<CS::pixels> window_size(window_width, window_height);
 static constexpr Size<CS::pixels> half_window_size(0.5 * window_width, 0.5 * window_height);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CS.h"
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+// A view of points in coordinate system cs that are stored as separate x and y arrays (structure of arrays).
+//
+// T is `double const` for a read-only view (the input of Transform::map) and `double` for a writable one
+// (its output). Tagging raw arrays with a coordinate system must be done explicitly, by constructing the view;
+// after that the CS template parameter keeps the compile-time checks, just like for Point<cs>.
+template<CS cs, typename T = double const>
+class SoAView
+{
+  static_assert(std::is_same_v<std::remove_const_t<T>, double>, "SoAView is a view of double or double const.");
+
+ private:
+  std::span<T> x_;
+  std::span<T> y_;
+
+ public:
+  constexpr SoAView(std::span<T> x, std::span<T> y) : x_(x), y_(y) { }
+
+  // A writable view can be used where a read-only view is expected.
+  // This is a template, so that it is not a (deleted) copy constructor of the writable view.
+  template<typename U = T>
+  requires std::is_const_v<U>
+  constexpr SoAView(SoAView<cs, double> const& view) : x_(view.x()), y_(view.y()) { }
+
+  constexpr std::span<T> x() const { return x_; }
+  constexpr std::span<T> y() const { return y_; }
+  constexpr std::size_t size() const { return x_.size(); }
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// A minimal wall-clock stopwatch for the benchmark programs in this directory.
+class Stopwatch
+{
+ private:
+  using clock_type = std::chrono::steady_clock;
+
+  clock_type::time_point start_;
+  clock_type::duration elapsed_{};
+
+ public:
+  void start() { start_ = clock_type::now(); }
+  void stop() { elapsed_ += clock_type::now() - start_; }
+  void reset() { elapsed_ = {}; }
+  // Add the elapsed time of another stopwatch (for example, one that ran in a different thread).
+  void add(Stopwatch const& other) { elapsed_ += other.elapsed_; }
+
+  double elapsed_seconds() const { return std::chrono::duration<double>(elapsed_).count(); }
+
+  // Return the average time per operation in nanoseconds.
+  double ns_per(uint64_t operations) const
+  {
+    return std::chrono::duration<double, std::nano>(elapsed_).count() / operations;
+  }
+};
+
+// Prevent the compiler from optimizing away the computation of `value`.
+template<typename T>
+inline void do_not_optimize(T const& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "NiceDelta.h"
+#include "Range.h"
+#include <array>
+#include <cmath>
+
+// Major, minor and sub-minor tick marks of a range.
+//
+// The major level is NiceDelta(range); each next level is derived from the previous one with
+// NiceDelta::finer (1→0.5, 2→1, 5→1), so that every tick of a coarser level is also a tick
+// of all finer levels. Tick k of a level has the value k * level(level).value().
+template<CS cs>
+class TickHierarchy
+{
+ public:
+  static constexpr int number_of_levels = 3;
+  static constexpr int major = 0;
+  static constexpr int minor = 1;
+  static constexpr int sub_minor = 2;
+
+  // The ticks of one level that have the same value and spacing as ticks of a previous TickHierarchy.
+  struct StableTicks
+  {
+    int previous_level;         // The level of the previous hierarchy with the same spacing, or -1 if there is none.
+    int k_min;                  // The first tick that exists in both.
+    int k_max;                  // The last tick that exists in both; less than k_min if there is none.
+  };
+
+ private:
+  std::array<NiceDelta<cs>, number_of_levels> levels_;
+  std::array<int, number_of_levels> k_min_{};   // The first tick of each level that lies in the range.
+
+ public:
+  // Construct an invalid hierarchy (no ticks).
+  TickHierarchy() = default;
+
+  explicit TickHierarchy(Range<cs> const& range)
+  {
+    levels_[major] = NiceDelta<cs>{range};
+    for (int level = minor; level < number_of_levels; ++level)
+      levels_[level] = levels_[level - 1].finer(range);
+    for (int level = major; level < number_of_levels; ++level)
+      k_min_[level] = std::ceil(range.min() / levels_[level].value());
+  }
+
+  bool is_invalid() const { return levels_[major].is_invalid(); }
+
+  NiceDelta<cs> const& level(int level) const { return levels_[level]; }
+  int k_min(int level) const { return k_min_[level]; }
+  int k_max(int level) const { return k_min_[level] + levels_[level].m() - 1; }
+
+  // Return the coarsest level that tick k of level also belongs to.
+  int coarsest_level(int level, int k) const
+  {
+    while (level > major && k % levels_[level - 1].subdivisions() == 0)
+    {
+      k /= levels_[level - 1].subdivisions();
+      --level;
+    }
+    return level;
+  }
+
+  // Return for each level which of its ticks already existed in previous, with the same value and spacing.
+  //
+  // A level whose spacing is the spacing of some level of previous (for example, after zooming in,
+  // the old minor level can become the new major level) keeps the labels of its ticks.
+  std::array<StableTicks, number_of_levels> stable_ticks(TickHierarchy const& previous) const
+  {
+    std::array<StableTicks, number_of_levels> result;
+    for (int level = major; level < number_of_levels; ++level)
+    {
+      result[level] = {-1, 0, -1};
+      if (is_invalid() || previous.is_invalid())
+        continue;
+      for (int previous_level = major; previous_level < number_of_levels; ++previous_level)
+      {
+        NiceDelta<cs> const& previous_delta = previous.levels_[previous_level];
+        if (previous_delta.mantissa_index() == levels_[level].mantissa_index() && previous_delta.exponent() == levels_[level].exponent())
+        {
+          result[level] = {previous_level,
+            std::max(k_min(level), previous.k_min(previous_level)), std::min(k_max(level), previous.k_max(previous_level))};
+          break;
+        }
+      }
+    }
+    return result;
+  }
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "TickHierarchy.h"
+#include "Transform.h"
+#include "Point.h"
+#include "Vector.h"
+#include "cairowindow/draw/PlotArea.h"          // x_axis, y_axis
+#include "math/Direction.h"
+#include <cstddef>
+#include <iterator>
+
+// The quantities of an axis that are the same for all of its tick marks (in CS::pixels).
+template<CS cs>
+struct TickAxis
+{
+  Point<CS::pixels> origin;             // The origin of cs.
+  Vector<CS::pixels> unit;              // The vector from the origin to the point at distance 1 (in cs) along the axis.
+  math::Direction<2> direction;         // The direction of the positive axis.
+  math::Direction<2> tick_direction;    // Perpendicular to the axis: the side of the axis where tick marks and labels are drawn.
+
+  TickAxis() = default;
+
+  TickAxis(int axis, Transform<cs, CS::pixels> const& cs_transform_pixels) :
+    origin(Point<cs>{} * cs_transform_pixels)
+  {
+    Point<cs> const unit_cs{axis == cairowindow::plot::x_axis ? 1.0 : 0.0, axis == cairowindow::plot::y_axis ? 1.0 : 0.0};
+    Point<CS::pixels> const unit_pixels = unit_cs * cs_transform_pixels;
+    unit = Vector<CS::pixels>{origin, unit_pixels};
+    direction = math::Direction<2>{origin, unit_pixels};
+    // Tick marks of the x-axis point to the right of its direction, those of the y-axis to the left.
+    tick_direction = axis == cairowindow::plot::x_axis ? direction.normal_inverse() : direction.normal();
+  }
+};
+
+// A tick mark, as generated by TickRange.
+template<CS cs>
+struct Tick
+{
+  int k;                                // The tick index: the tick has the value k * delta.
+  double value;                         // The coordinate of the tick along the axis (in cs).
+  Point<CS::pixels> position;           // Where the tick mark touches the axis.
+  Point<CS::pixels> end;                // The other end of the tick mark.
+  Point<CS::pixels> label_anchor;       // Where the label of the tick is anchored.
+};
+
+// The tick marks of one level of a TickHierarchy, generated on the fly.
+//
+// The origin (k == 0), ticks that also belong to a coarser level and ticks whose k is not a multiple
+// of the stride are skipped.
+// Iterating does not allocate; a renderer can consume the ticks in batches of any size.
+template<CS cs>
+class TickRange
+{
+ private:
+  TickHierarchy<cs> const* ticks_;
+  int level_;
+  int stride_;                          // Only generate ticks whose k is a multiple of stride_.
+  double delta_;                        // The distance between two ticks of this level (in cs).
+  Point<CS::pixels> origin_;            // Copied from the TickAxis.
+  Vector<CS::pixels> unit_;             // Idem.
+  Vector<CS::pixels> tick_offset_;      // From position to end.
+  Vector<CS::pixels> label_offset_;     // From position to label_anchor.
+
+ public:
+  class iterator
+  {
+   private:
+    TickRange const* range_;
+    int k_;
+
+    void skip()
+    {
+      while (k_ <= range_->k_max() && !range_->is_drawn(k_))
+        ++k_;
+    }
+
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Tick<cs>;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    iterator(TickRange const* range, int k) : range_(range), k_(k) { skip(); }
+
+    Tick<cs> operator*() const { return range_->tick(k_); }
+
+    iterator& operator++() { ++k_; skip(); return *this; }
+    iterator operator++(int) { iterator tmp = *this; ++*this; return tmp; }
+
+    friend bool operator==(iterator const& lhs, iterator const& rhs) { return lhs.k_ == rhs.k_; }
+  };
+
+  // The ticks of level of ticks along axis; each tick mark is tick_length pixels long and its label
+  // is anchored at label_distance pixels from the axis. If stride is larger than one, only every stride-th tick is generated.
+  TickRange(TickHierarchy<cs> const& ticks, int level, TickAxis<cs> const& axis, double tick_length, double label_distance,
+      int stride = 1) :
+    ticks_(&ticks), level_(level), stride_(stride), delta_(ticks.level(level).value()), origin_(axis.origin), unit_(axis.unit),
+    tick_offset_(axis.tick_direction, tick_length), label_offset_(axis.tick_direction, label_distance) { }
+
+  int k_min() const { return ticks_->k_min(level_); }
+  int k_max() const { return ticks_->k_max(level_); }
+
+  // An upper bound for the number of ticks in the range (for reserving storage).
+  std::size_t max_size() const { return ticks_->level(level_).m(); }
+
+  // Return true if tick k is generated by this range.
+  bool is_drawn(int k) const { return k != 0 && k % stride_ == 0 && ticks_->coarsest_level(level_, k) == level_; }
+
+  // Return tick k.
+  Tick<cs> tick(int k) const
+  {
+    double const value = k * delta_;
+    Point<CS::pixels> const position{origin_.x() + value * unit_.x(), origin_.y() + value * unit_.y()};
+    return {k, value, position, position + tick_offset_, position + label_offset_};
+  }
+
+  iterator begin() const { return {this, k_min()}; }
+  iterator end() const { return {this, k_max() + 1}; }
+};
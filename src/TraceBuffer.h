@@ -0,0 +1,215 @@
+#pragma once
+
+// Binary tracing of the hot paths of CoordinateSystem.
+//
+// Configure with -DEnableBinaryTrace=ON to define TRANSFORM_BINARY_TRACE. In that mode the debug output of
+// the instrumented code is replaced by events that consist of an Event id and the raw arguments; these are
+// written into a lock-free ring buffer and only formatted when the buffer is dumped:
+//
+//   TRACE_OR_DOUT((trace::Event::set_range, axis, range.min(), range.max(), this),
+//       DoutEntering(dc::notice, "CoordinateSystem::set_range(" << axis << ", " << range << ") [" << this << "]"));
+//
+//   TRACE_DUMP(std::cerr);     // Format everything that is still in the ring buffer.
+//
+// Without TRANSFORM_BINARY_TRACE, TRACE_OR_DOUT is just its second argument.
+
+#ifdef TRANSFORM_BINARY_TRACE
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include "debug.h"
+
+namespace trace {
+
+enum class Event : uint32_t
+{
+  constructor,
+  set_transform,
+  set_range,
+  reuse_tick_level,
+  range_ticks,
+  line_piece,
+  axis_range_cs,
+  label_stride,
+  dropped_tick_levels,
+  display,
+  dirty_region,
+  number_of_events
+};
+
+// How each event is formatted. Every {d} (double), {i} (integer) or {p} (pointer) is replaced by the next argument.
+inline char const* format(Event event)
+{
+  static constexpr std::array<char const*, static_cast<int>(Event::number_of_events)> formats = {
+    "CoordinateSystem::CoordinateSystem([{d}, {d}, {d}, {d}, {d}, {d}], axis_style) [{p}]",
+    "CoordinateSystem::set_transform([{d}, {d}, {d}, {d}, {d}, {d}]) [{p}]",
+    "CoordinateSystem::set_range({i}, [{d}, {d}]) [{p}]",
+    "Level {i} reuses level {i}; ticks [{i}, {i}] are unchanged.",
+    "range_[{i}] = [{d}, {d}]; major delta = {d} (m = {i})",
+    "line_piece_[{i}] = ({d}, {d}) - ({d}, {d})",
+    "from_cs = ({d}, {d}); to_cs = ({d}, {d})",
+    "Axis {i}: major tick spacing is {d} pixels; drawing every {i}th tick and every {i}th label.",
+    "Axis {i}: not drawing tick levels {i} and up.",
+    "CoordinateSystem::display(layer) [{p}]",
+    "dirty_region = ({d}, {d}) - ({d}, {d})"
+  };
+  return formats[static_cast<int>(event)];
+}
+
+class TraceBuffer
+{
+ public:
+  static constexpr int max_arguments = 7;
+  static constexpr std::size_t default_capacity = 16384;        // Must be a power of two.
+
+  struct Record
+  {
+    uint64_t timestamp_ns;                              // Since the construction of the TraceBuffer.
+    Event event;
+    uint32_t number_of_arguments;
+    std::array<uint64_t, max_arguments> arguments;      // The bits of each argument.
+  };
+
+ private:
+  using clock_type = std::chrono::steady_clock;
+
+  // A Record, stored as atomic words so that dump() may read a slot while another thread writes it
+  // (and two writers that reach the same slot after the buffer wrapped around don't race).
+  // All accesses of the words are relaxed; the sequence number tells if they belong together.
+  struct Slot
+  {
+    // 2 * n + 1 while record n is being written to this slot, 2 * n + 2 once it is complete.
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> timestamp_ns{0};
+    std::atomic<uint64_t> header{0};                    // The Event in the lower 32 bits, the number of arguments in the upper 32 bits.
+    std::array<std::atomic<uint64_t>, max_arguments> arguments{};
+  };
+
+  std::size_t const mask_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> head_{0};                       // The number of records that were ever started.
+  clock_type::time_point const epoch_;
+
+  template<typename T>
+  static uint64_t to_bits(T value)
+  {
+    if constexpr (std::is_floating_point_v<T>)
+      return std::bit_cast<uint64_t>(static_cast<double>(value));
+    else if constexpr (std::is_pointer_v<T>)
+      return reinterpret_cast<uintptr_t>(value);
+    else
+    {
+      static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "Unsupported trace argument type.");
+      return static_cast<uint64_t>(static_cast<int64_t>(value));
+    }
+  }
+
+ public:
+  explicit TraceBuffer(std::size_t capacity = default_capacity) :
+    mask_(capacity - 1), slots_(new Slot[capacity]), epoch_(clock_type::now())
+  {
+    // The capacity must be a power of two.
+    ASSERT(std::has_single_bit(capacity));
+  }
+
+  static TraceBuffer& instance()
+  {
+    static TraceBuffer trace_buffer;
+    return trace_buffer;
+  }
+
+  // Record an event. This never blocks; when the buffer is full the oldest records are overwritten.
+  template<typename... Args>
+  void record(Event event, Args... args)
+  {
+    static_assert(sizeof...(Args) <= max_arguments, "Too many trace arguments.");
+    uint64_t const n = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[n & mask_];
+    slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestamp_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - epoch_).count(), std::memory_order_relaxed);
+    slot.header.store(static_cast<uint64_t>(event) | uint64_t{sizeof...(Args)} << 32, std::memory_order_relaxed);
+    std::size_t i = 0;
+    (slot.arguments[i++].store(to_bits(args), std::memory_order_relaxed), ...);
+    slot.sequence.store(2 * n + 2, std::memory_order_release);
+  }
+
+  // Format the records that are still in the buffer, oldest first.
+  // This may be called while other threads record: records that are being (over)written while dumping are skipped.
+  void dump(std::ostream& os) const
+  {
+    uint64_t const head = head_.load(std::memory_order_acquire);
+    uint64_t const capacity = mask_ + 1;
+    for (uint64_t n = head > capacity ? head - capacity : 0; n < head; ++n)
+    {
+      Slot const& slot = slots_[n & mask_];
+      if (slot.sequence.load(std::memory_order_acquire) != 2 * n + 2)
+        continue;
+      Record record;
+      record.timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+      uint64_t const header = slot.header.load(std::memory_order_relaxed);
+      record.event = static_cast<Event>(header & 0xffffffff);
+      record.number_of_arguments = header >> 32;
+      for (int i = 0; i < max_arguments; ++i)
+        record.arguments[i] = slot.arguments[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != 2 * n + 2)
+        continue;
+      print(os, record);
+    }
+  }
+
+  static void print(std::ostream& os, Record const& record)
+  {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%12.3f us: ", record.timestamp_ns * 1e-3);
+    os << buffer;
+    uint32_t argument = 0;
+    for (char const* f = format(record.event); *f; ++f)
+    {
+      if (f[0] == '{' && f[1] && f[2] == '}' && argument < record.number_of_arguments)
+      {
+        uint64_t const bits = record.arguments[argument++];
+        switch (f[1])
+        {
+          case 'd':
+            os << std::bit_cast<double>(bits);
+            break;
+          case 'i':
+            os << static_cast<int64_t>(bits);
+            break;
+          case 'p':
+            std::snprintf(buffer, sizeof(buffer), "%#llx", static_cast<unsigned long long>(bits));
+            os << buffer;
+            break;
+        }
+        f += 2;
+      }
+      else
+        os << *f;
+    }
+    os << '\n';
+  }
+};
+
+} // namespace trace
+
+#define TRACE_EVENT(...) ::trace::TraceBuffer::instance().record(__VA_ARGS__)
+#define TRACE_OR_DOUT(event_args, dout_statement) TRACE_EVENT event_args
+#define TRACE_DUMP(os) ::trace::TraceBuffer::instance().dump(os)
+
+#else // TRANSFORM_BINARY_TRACE
+
+#define TRACE_EVENT(...) do { } while (0)
+#define TRACE_OR_DOUT(event_args, dout_statement) dout_statement
+#define TRACE_DUMP(os) do { } while (0)
+
+#endif // TRANSFORM_BINARY_TRACE
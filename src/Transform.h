@@ -1,10 +1,19 @@
 #pragma once
 
 #include "TranslationVector.h"
-#include <QTransform>
+#include "AffineTransform.h"
+#include "SoAView.h"
+#include <span>
 #include <sstream>
 #include <algorithm>
+#include <array>
 #include <iomanip>
+#include <tuple>
+#include <utility>
+#include "debug.h"
+
+template<CS from_cs, CS to_cs, typename... Links>
+class TransformChain;
 
 template<CS from_cs, CS to_cs, bool inverted = false>
 class Transform
@@ -13,17 +22,29 @@ class Transform
   template<CS from_cs2, CS to_cs2, bool inverted2>
   friend class Transform;
 
-  QTransform m_;
+  template<CS from_cs2, CS to_cs2, typename... Links>
+  friend class TransformChain;
+
+  AffineTransform m_;           // The non-inverted matrix, converting from from_cs to to_cs when !inverted.
+  AffineTransform inv_;         // The inverse of m_, kept up to date by every operation that changes m_.
+  double det_ = 1.0;            // The determinant of m_; zero if m_ is singular (inv_ is then meaningless).
 
  private:
-  Transform(QTransform const& m) : m_(m) { }
+  constexpr Transform(AffineTransform const& m, AffineTransform const& inv, double det) : m_(m), inv_(inv), det_(det) { }
+
+  // The matrix that maps from_cs to to_cs, and the one that maps back.
+  constexpr AffineTransform const& forward() const { if constexpr (!inverted) return m_; else return inv_; }
+  constexpr AffineTransform const& backward() const { if constexpr (!inverted) return inv_; else return m_; }
+
+  // Same as inverse(), but returns a copy (which can be used in constant expressions).
+  constexpr Transform<to_cs, from_cs, !inverted> inverse_copy() const { return {m_, inv_, det_}; }
 
  public:
-  Transform() = default;
+  constexpr Transform() = default;
 
-  Transform& translate(TranslationVector<to_cs> const& tv);
-  Transform& scale(qreal s);
-  Transform& rotate(qreal alpha);
+  constexpr Transform& translate(TranslationVector<to_cs> const& tv);
+  constexpr Transform& scale(double s);
+  constexpr Transform& rotate(double alpha);
 
   // The inverse converts from `to_cs` to `from_cs`!
   Transform<to_cs, from_cs, !inverted> const& inverse() const
@@ -31,9 +52,24 @@ class Transform
     return reinterpret_cast<Transform<to_cs, from_cs, !inverted> const&>(*this);
   }
 
+  // The matrix that converts from `from_cs` to `to_cs`.
+  constexpr AffineTransform const& matrix() const { return forward(); }
+
+  // The inverse is derived from m_, so it suffices to compare m_.
+  friend constexpr bool operator==(Transform const& lhs, Transform const& rhs) { return lhs.m_ == rhs.m_; }
+
+  // The determinant of the matrix that converts from `from_cs` to `to_cs`.
+  constexpr double determinant() const { if constexpr (!inverted) return det_; else return 1.0 / det_; }
+  constexpr bool is_invertible() const { return det_ != 0.0; }
+
   Point<to_cs> multiply_from_the_right_with(Point<from_cs> const& point) const;
   Size<to_cs> multiply_from_the_right_with(Size<from_cs> const& size) const;
 
+  // Map all points of `in` and write the result to `out` (which must have the same size).
+  void map(std::span<Point<from_cs> const> in, std::span<Point<to_cs>> out) const;
+  // Same, but for points stored as separate x and y arrays (structure of arrays).
+  void map(SoAView<from_cs> in, SoAView<to_cs, double> out) const;
+
   // Let A_M1_B be non-inverted and convert from A to B.
   // Let B_M2_C be non-inverted and convert from B to C.
   //
@@ -59,44 +95,24 @@ class Transform
   // Multiplication between a non-inverted Transform and an inverted Transform.
   // 4. A_M7_C = A_M78_B * B_M8inv_C
   //
-  // Then using specializations, where from_cs = A, to_cs = B and result_cs = C we'd have:
-  //
-  // Specialization for 1.
-  // std::enable_if_t<!inverted, Transform<from_cs, result_cs, false>> operator*(Transform<to_cs, result_cs, false> const& rhs) const;
-  //
-  // Specialization for 2.
-  // std::enable_if_t<inverted, Transform<from_cs, result_cs, true>> operator*(Transform<to_cs, result_cs, true> const& rhs) const;
-  //
-  // Specialization for 3.
-  // std::enable_if_t<inverted, Transform<from_cs, result_cs, false>> operator*(Transform<to_cs, result_cs, false> const& rhs) const;
-  //
-  // Specialization for 4.
-  //std::enable_if_t<!inverted, Transform<from_cs, result_cs, false>> operator*(Transform<to_cs, result_cs, true> const& rhs) const;
+  // Since both m_ and its inverse inv_ are stored, none of the above cases needs to invert a matrix:
+  // forward() and backward() select, at compile time, the matrix that converts A to B respectively
+  // B to A, and (X * Y)^-1 = Y^-1 * X^-1 gives the inverse of a product for free.
   //
+  // The multiplication is lazy: it returns a TransformChain that only stores its factors.
+  // The chain is collapsed into a single matrix when it is applied to a point, or when it is
+  // converted to a Transform.
   template<CS result_cs, bool rhs_inverted>
-  Transform<from_cs, result_cs, inverted && rhs_inverted> operator*(Transform<to_cs, result_cs, rhs_inverted> const& rhs) const
+  constexpr TransformChain<from_cs, result_cs, Transform, Transform<to_cs, result_cs, rhs_inverted>>
+  operator*(Transform<to_cs, result_cs, rhs_inverted> const& rhs) const
   {
-    // 1. Multiplication between two non-inverted Transforms.
-    if constexpr (!inverted && !rhs_inverted)
-    {
-      return {m_ * rhs.m_};
-    }
-    // 2. Multiplication between two inverted Transforms.
-    else if constexpr (inverted && rhs_inverted)
-    {
-      // A^-1 * B^-1 = (B * A)^-1
-      return {rhs.m_ * m_};
-    }
-    // 3. Multiplication between an inverted Transform and a non-inverted Transform.
-    else if constexpr (inverted && !rhs_inverted)
-    {
-      return {m_.inverted() * rhs.m_};
-    }
-    // 4. Multiplication between a non-inverted Transform and an inverted Transform.
-    else if constexpr (!inverted && rhs_inverted)
-    {
-      return {m_ * rhs.m_.inverted()};
-    }
+    return {*this, rhs};
+  }
+
+  template<CS result_cs, typename... Links>
+  constexpr TransformChain<from_cs, result_cs, Transform, Links...> operator*(TransformChain<to_cs, result_cs, Links...> const& rhs) const
+  {
+    return std::tuple_cat(std::tuple<Transform>{*this}, rhs.links_);
   }
 
   void print_on(std::ostream& os) const
@@ -106,45 +122,93 @@ class Transform
     int const prefix_len = std::max((int)prefix.str().length(), 24);
 
     os << '\n' << std::setw(prefix_len) << " " <<
-      std::left << "⎛" << std::setw(9) << m_.m11() << " " << std::setw(9) << m_.m12() << " " << m_.m13() << "⎞" << std::right;
+      std::left << "⎛" << std::setw(9) << m_.m11() << " " << std::setw(9) << m_.m12() << " " << 0 << "⎞" << std::right;
     os << '\n' << std::right << std::setw(prefix_len) << prefix.str() <<
-      std::left << "⎜" << std::setw(9) << m_.m21() << " " << std::setw(9) << m_.m22() << " " << m_.m23() << "⎟" << std::right;
+      std::left << "⎜" << std::setw(9) << m_.m21() << " " << std::setw(9) << m_.m22() << " " << 0 << "⎟" << std::right;
     os << '\n' << std::setw(prefix_len) << " " <<
-      std::left << "⎝" << std::setw(9) << m_.m31() << " " << std::setw(9) << m_.m32() << " " << m_.m33() << "⎠" << std::right;
+      std::left << "⎝" << std::setw(9) << m_.dx() << " " << std::setw(9) << m_.dy() << " " << 1 << "⎠" << std::right;
   }
 };
 
 template<CS from_cs, CS to_cs, bool inverted>
-Transform<from_cs, to_cs, inverted>& Transform<from_cs, to_cs, inverted>::translate(TranslationVector<to_cs> const& tv)
+constexpr Transform<from_cs, to_cs, inverted>& Transform<from_cs, to_cs, inverted>::translate(TranslationVector<to_cs> const& tv)
 {
   m_.translate(tv.x(), tv.y());
+  // m_ became T * m_, so its inverse becomes inv_ * T^-1.
+  inv_ *= AffineTransform::from_translate(-tv.x(), -tv.y());
   return *this;
 }
 
 template<CS from_cs, CS to_cs, bool inverted>
-Transform<from_cs, to_cs, inverted>& Transform<from_cs, to_cs, inverted>::scale(qreal s)
+constexpr Transform<from_cs, to_cs, inverted>& Transform<from_cs, to_cs, inverted>::scale(double s)
 {
   m_.scale(s, s);
+  det_ *= s * s;
+  if (det_ != 0.0)
+    inv_ *= AffineTransform::from_scale(1.0 / s, 1.0 / s);
   return *this;
 }
 
 template<CS from_cs, CS to_cs, bool inverted>
-Transform<from_cs, to_cs, inverted>& Transform<from_cs, to_cs, inverted>::rotate(qreal alpha)
+constexpr Transform<from_cs, to_cs, inverted>& Transform<from_cs, to_cs, inverted>::rotate(double alpha)
 {
   m_.rotate(alpha);
+  inv_ *= AffineTransform{}.rotate(-alpha);
   return *this;
 }
 
 template<CS from_cs, CS to_cs, bool inverted>
 Point<to_cs> Transform<from_cs, to_cs, inverted>::multiply_from_the_right_with(Point<from_cs> const& point) const
 {
-  QPointF p{point.x(), point.y()};
-  QPointF result;
-  if constexpr (!inverted)
-    result = m_.map(p);
-  else
-    result = m_.inverted().map(p);
-  return {result.x(), result.y()};
+  AffineTransform const& m = forward();
+  return {m.map_x(point.x(), point.y()), m.map_y(point.x(), point.y())};
+}
+
+namespace detail {
+
+template<CS from_cs, CS to_cs>
+void map_points(AffineCoefficients const& m, std::span<Point<from_cs> const> in, std::span<Point<to_cs>> out)
+{
+  ASSERT(in.size() == out.size());
+
+  // Transpose blocks of points into x[] and y[] arrays on the stack, so the SIMD kernel can be used
+  // independent of the memory layout of Point.
+  constexpr std::size_t block_size = 64;
+  alignas(32) double x[block_size];
+  alignas(32) double y[block_size];
+  for (std::size_t first = 0; first < in.size(); first += block_size)
+  {
+    std::size_t const n = std::min(block_size, in.size() - first);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      x[i] = in[first + i].x();
+      y[i] = in[first + i].y();
+    }
+    affine_map(m, x, y, x, y, n);
+    for (std::size_t i = 0; i < n; ++i)
+      out[first + i] = Point<to_cs>{x[i], y[i]};
+  }
+}
+
+template<CS from_cs, CS to_cs>
+void map_arrays(AffineCoefficients const& m, SoAView<from_cs> in, SoAView<to_cs, double> out)
+{
+  ASSERT(in.y().size() == in.size() && out.x().size() == in.size() && out.y().size() == in.size());
+  affine_map(m, in.x().data(), in.y().data(), out.x().data(), out.y().data(), in.size());
+}
+
+} // namespace detail
+
+template<CS from_cs, CS to_cs, bool inverted>
+void Transform<from_cs, to_cs, inverted>::map(std::span<Point<from_cs> const> in, std::span<Point<to_cs>> out) const
+{
+  detail::map_points(forward().coefficients(), in, out);
+}
+
+template<CS from_cs, CS to_cs, bool inverted>
+void Transform<from_cs, to_cs, inverted>::map(SoAView<from_cs> in, SoAView<to_cs, double> out) const
+{
+  detail::map_arrays(forward().coefficients(), in, out);
 }
 
 template<CS from_cs, CS to_cs, bool inverted>
@@ -157,8 +221,8 @@ template<CS from_cs, CS to_cs, bool inverted>
 Size<to_cs> Transform<from_cs, to_cs, inverted>::multiply_from_the_right_with(Size<from_cs> const& size) const
 {
   // Just scale; scale the X and Y axis vectors by the full linear part.
-  qreal const sx = std::hypot(m_.m11(), m_.m12());
-  qreal const sy = std::hypot(m_.m21(), m_.m22());
+  double const sx = std::hypot(m_.m11(), m_.m12());
+  double const sy = std::hypot(m_.m21(), m_.m22());
   if constexpr (!inverted)
     return {size.width() * sx, size.height() * sy};
   else
@@ -170,3 +234,156 @@ Size<to_cs> operator*(Size<from_cs> const& size, Transform<from_cs, to_cs, inver
 {
   return transform.multiply_from_the_right_with(size);
 }
+
+namespace detail {
+
+template<typename Link>
+struct TransformLink;
+
+template<CS from_cs, CS to_cs, bool inverted>
+struct TransformLink<Transform<from_cs, to_cs, inverted>>
+{
+  static constexpr CS from = from_cs;
+  static constexpr CS to = to_cs;
+};
+
+// Return true if Links convert from `from_cs` to `to_cs`, each link converting to the coordinate system that the next one converts from.
+template<CS from_cs, CS to_cs, typename... Links>
+constexpr bool is_connected_chain()
+{
+  constexpr std::size_t n = sizeof...(Links);
+  constexpr std::array<CS, n> link_from = { TransformLink<Links>::from... };
+  constexpr std::array<CS, n> link_to = { TransformLink<Links>::to... };
+  if (n == 0 || link_from.front() != from_cs || link_to.back() != to_cs)
+    return false;
+  for (std::size_t i = 0; i + 1 < n; ++i)
+    if (link_to[i] != link_from[i + 1])
+      return false;
+  return true;
+}
+
+} // namespace detail
+
+// The lazy product of two or more Transforms, where each Transform converts to the coordinate system
+// that the next one converts from. Only created by Transform::operator*, TransformChain::operator*
+// and inverse(), which connect the links through their CS template parameters.
+template<CS from_cs, CS to_cs, typename... Links>
+class TransformChain
+{
+  static_assert(detail::is_connected_chain<from_cs, to_cs, Links...>(),
+      "The links of a TransformChain must convert from from_cs to to_cs, each one to the coordinate system of the next.");
+
+ private:
+  template<CS from_cs2, CS to_cs2, bool inverted2>
+  friend class Transform;
+
+  template<CS from_cs2, CS to_cs2, typename... Links2>
+  friend class TransformChain;
+
+  std::tuple<Links...> links_;
+
+  constexpr TransformChain(Links const&... links) : links_(links...) { }
+  constexpr TransformChain(std::tuple<Links...> const& links) : links_(links) { }
+
+ public:
+  // Return the product of all matrices that convert from `from_cs` to `to_cs`.
+  constexpr AffineTransform forward() const
+  {
+    return std::apply([](auto const&... link){ return (... * link.forward()); }, links_);
+  }
+
+  // Return the product of all matrices that convert from `to_cs` back to `from_cs`.
+  constexpr AffineTransform backward() const
+  {
+    return std::apply([](auto const&... link){
+      AffineTransform result;
+      ((result = link.backward() * result), ...);
+      return result;
+    }, links_);
+  }
+
+  constexpr double determinant() const
+  {
+    return std::apply([](auto const&... link){ return (... * link.determinant()); }, links_);
+  }
+
+  // Collapse the chain into a single Transform.
+  template<bool inverted>
+  constexpr operator Transform<from_cs, to_cs, inverted>() const
+  {
+    if constexpr (!inverted)
+      return {forward(), backward(), determinant()};
+    else
+      return {backward(), forward(), 1.0 / determinant()};
+  }
+
+  constexpr Transform<from_cs, to_cs> evaluate() const { return *this; }
+
+  // The inverse chain converts from `to_cs` to `from_cs`, by applying the inverse of each link in reverse order.
+  constexpr auto inverse() const
+  {
+    constexpr std::size_t n = sizeof...(Links);
+    return [this]<std::size_t... I>(std::index_sequence<I...>) {
+      return TransformChain<to_cs, from_cs, decltype(std::get<n - 1 - I>(links_).inverse_copy())...>{
+        std::get<n - 1 - I>(links_).inverse_copy()...};
+    }(std::index_sequence_for<Links...>{});
+  }
+
+  template<CS result_cs, bool rhs_inverted>
+  constexpr TransformChain<from_cs, result_cs, Links..., Transform<to_cs, result_cs, rhs_inverted>>
+  operator*(Transform<to_cs, result_cs, rhs_inverted> const& rhs) const
+  {
+    return std::tuple_cat(links_, std::tuple<Transform<to_cs, result_cs, rhs_inverted>>{rhs});
+  }
+
+  template<CS result_cs, typename... RhsLinks>
+  constexpr TransformChain<from_cs, result_cs, Links..., RhsLinks...> operator*(TransformChain<to_cs, result_cs, RhsLinks...> const& rhs) const
+  {
+    return std::tuple_cat(links_, rhs.links_);
+  }
+
+  // Applying the chain to a point only needs the forward product.
+  Point<to_cs> multiply_from_the_right_with(Point<from_cs> const& point) const
+  {
+    AffineTransform const m = forward();
+    return {m.map_x(point.x(), point.y()), m.map_y(point.x(), point.y())};
+  }
+
+  // Same as Transform::multiply_from_the_right_with(Size), using the forward product.
+  Size<to_cs> multiply_from_the_right_with(Size<from_cs> const& size) const
+  {
+    AffineTransform const m = forward();
+    return {size.width() * std::hypot(m.m11(), m.m12()), size.height() * std::hypot(m.m21(), m.m22())};
+  }
+
+  void map(std::span<Point<from_cs> const> in, std::span<Point<to_cs>> out) const
+  {
+    detail::map_points(forward().coefficients(), in, out);
+  }
+
+  void map(SoAView<from_cs> in, SoAView<to_cs, double> out) const
+  {
+    detail::map_arrays(forward().coefficients(), in, out);
+  }
+
+  void print_on(std::ostream& os) const
+  {
+    evaluate().print_on(os);
+  }
+};
+
+// Every application of a chain multiplies all of its matrices (N - 1 matrix products for N links).
+// That is fine for `point * t1 * t2`, but a chain that is kept to map many points must be collapsed
+// first, with evaluate() or by converting it to a Transform.
+template<CS from_cs, CS to_cs, typename... Links>
+Point<to_cs> operator*(Point<from_cs> const& point, TransformChain<from_cs, to_cs, Links...> const& chain)
+{
+  return chain.multiply_from_the_right_with(point);
+}
+
+// The same applies to sizes.
+template<CS from_cs, CS to_cs, typename... Links>
+Size<to_cs> operator*(Size<from_cs> const& size, TransformChain<from_cs, to_cs, Links...> const& chain)
+{
+  return chain.multiply_from_the_right_with(size);
+}
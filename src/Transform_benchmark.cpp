@@ -0,0 +1,96 @@
+#include "sys.h"
+#include "Transform.h"
+#include "Stopwatch.h"
+#include <iostream>
+#include <random>
+#include <vector>
+#include "debug.h"
+
+int main()
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  constexpr int number_of_points = 10000;     // Small enough to stay in the cache.
+  constexpr int repeat = 1000;
+
+  Transform<CS::centered, CS::pixels> const centered_transform_pixels =
+    Transform<CS::centered, CS::pixels>{}.translate(half_window_size).scale(half_window_size.height()).rotate(30.0);
+  auto const& pixels_transform_centered = centered_transform_pixels.inverse();
+
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> x_distribution(0.0, window_width);
+  std::uniform_real_distribution<double> y_distribution(0.0, window_height);
+  std::vector<Point<CS::pixels>> points;
+  points.reserve(number_of_points);
+  for (int i = 0; i < number_of_points; ++i)
+    points.emplace_back(x_distribution(engine), y_distribution(engine));
+
+  // The matrix of centered_transform_pixels, for the path that inverts it for every point.
+  AffineTransform m = centered_transform_pixels.matrix();
+
+  Stopwatch forward;
+  Stopwatch cached_inverse;
+  Stopwatch inverted_per_point;
+  for (int r = 0; r < repeat; ++r)
+  {
+    forward.start();
+    for (Point<CS::pixels> const& point : points)
+    {
+      Point<CS::pixels> result = Point<CS::centered>{point.x(), point.y()} * centered_transform_pixels;
+      do_not_optimize(result);
+    }
+    forward.stop();
+
+    cached_inverse.start();
+    for (Point<CS::pixels> const& point : points)
+    {
+      Point<CS::centered> result = point * pixels_transform_centered;
+      do_not_optimize(result);
+    }
+    cached_inverse.stop();
+
+    // What multiply_from_the_right_with did before the inverse was cached.
+    inverted_per_point.start();
+    for (Point<CS::pixels> const& point : points)
+    {
+      do_not_optimize(m);       // Stop the compiler from hoisting the inversion out of the loop.
+      AffineTransform const inverse = m.inverted();
+      Point<CS::centered> result{inverse.map_x(point.x(), point.y()), inverse.map_y(point.x(), point.y())};
+      do_not_optimize(result);
+    }
+    inverted_per_point.stop();
+  }
+
+  // Batch mapping of the same points.
+  std::vector<Point<CS::centered>> mapped_points(number_of_points);
+  std::vector<double> x(number_of_points);
+  std::vector<double> y(number_of_points);
+  for (int i = 0; i < number_of_points; ++i)
+  {
+    x[i] = points[i].x();
+    y[i] = points[i].y();
+  }
+  std::vector<double> x_out(number_of_points);
+  std::vector<double> y_out(number_of_points);
+  Stopwatch batch_aos;
+  Stopwatch batch_soa;
+  for (int r = 0; r < repeat; ++r)
+  {
+    batch_aos.start();
+    pixels_transform_centered.map(points, mapped_points);
+    batch_aos.stop();
+    do_not_optimize(mapped_points.back());
+
+    batch_soa.start();
+    pixels_transform_centered.map(SoAView<CS::pixels>{x, y}, SoAView<CS::centered, double>{x_out, y_out});
+    batch_soa.stop();
+    do_not_optimize(x_out.back());
+  }
+
+  uint64_t const total = uint64_t{number_of_points} * repeat;
+  std::cout << "Forward mapping:                      " << forward.ns_per(total) << " ns/point\n";
+  std::cout << "Inverse mapping (cached inverse):     " << cached_inverse.ns_per(total) << " ns/point\n";
+  std::cout << "Inverse mapping (inverted per point): " << inverted_per_point.ns_per(total) << " ns/point\n";
+  std::cout << "Inverse mapping (batch, AoS):         " << batch_aos.ns_per(total) << " ns/point\n";
+  std::cout << "Inverse mapping (batch, SoA):         " << batch_soa.ns_per(total) << " ns/point\n";
+}
@@ -2,26 +2,30 @@
 
 #include "Point.h"
 #include "Size.h"
-#include "math/Vector.h"
+#include <type_traits>
 
 template<CS cs>
 class TranslationVector
 {
  private:
-  math::Vector<2> translation_;
+  double x_;
+  double y_;
 
  private:
-  TranslationVector(math::Vector<2> const& translation) : translation_(translation) { }
+  constexpr TranslationVector(double x, double y) : x_(x), y_(y) { }
 
  public:
-  TranslationVector(Point<cs> const& point) : translation_(point.x(), point.y()) { }
-  TranslationVector(Size<cs> const& size) : translation_(size.width(), size.height()) { }
+  constexpr TranslationVector(Point<cs> const& point) : x_(point.x()), y_(point.y()) { }
+  constexpr TranslationVector(Size<cs> const& size) : x_(size.width()), y_(size.height()) { }
 
-  double x() const { return translation_.x(); }
-  double y() const { return translation_.y(); }
+  constexpr double x() const { return x_; }
+  constexpr double y() const { return y_; }
 
-  friend TranslationVector operator*(double scale, TranslationVector const& tv)
+  friend constexpr TranslationVector operator*(double scale, TranslationVector const& tv)
   {
-    return {scale * tv.translation_};
+    return {scale * tv.x_, scale * tv.y_};
   }
 };
+
+static_assert(std::is_trivially_copyable_v<TranslationVector<CS::pixels>>);
+static_assert(TranslationVector<CS::pixels>{Point<CS::pixels>{1.0, 2.0}}.y() == 2.0, "TranslationVector must be constexpr constructible.");
@@ -3,85 +3,95 @@
 #include "CS.h"
 #include "Point.h"
 #include "cairowindow/Vector.h"
+#include <type_traits>
 
+// A vector in coordinate system cs.
+//
+// Like Point, this stores its coordinates directly so that it is trivially copyable and constexpr;
+// it converts implicitly to a cairowindow::Vector and explicitly from one.
 template<CS cs>
-class Vector : public cairowindow::Vector
+class Vector
 {
  private:
-  // This should not be public. We use this so we can just return calls to base class members that return a Vector by value.
-  Vector(cairowindow::Vector&& base) : cairowindow::Vector(base) { }
+  double x_;
+  double y_;
 
  public:
   // Construct an uninitialized Vector.
   Vector() = default;
 
-  // Copy constructor.
-  Vector(Vector const& orig) : cairowindow::Vector(orig) { }
-
   // Construct a vector from its x,y coordinates.
-  Vector(double x, double y) : cairowindow::Vector(x, y) { }
+  constexpr Vector(double x, double y) : x_(x), y_(y) { }
 
   // Construct a Vector that points in direction and has length.
   // Also used for automatic conversion from a Direction to a Vector.
-  Vector(math::Direction<2> direction, double length = 1.0) : cairowindow::Vector(direction, length) { }
+  Vector(math::Direction<2> direction, double length = 1.0) : x_(direction.x() * length), y_(direction.y() * length) { }
 
-  // Construct a Vector from two points. If the second point is not given it defaults to the origin.
-  // The direction is from the second argument (or origin) to the first argument.
-  Vector(Point<cs> const& from, Point<cs> const& to) : cairowindow::Vector(from, to) { }
-  explicit Vector(Point<cs> const& to) : cairowindow::Vector(to) { }
+  // Construct the Vector that points from `from` to `to`, or from the origin to `to` if only one point is given.
+  constexpr Vector(Point<cs> const& from, Point<cs> const& to) : x_(to.x() - from.x()), y_(to.y() - from.y()) { }
+  constexpr explicit Vector(Point<cs> const& to) : x_(to.x()), y_(to.y()) { }
 
   // Construct a Vector from a LinePiece, pointing from the first point to the second point.
-  explicit Vector(math::LinePiece<2> const& line_piece) : cairowindow::Vector(line_piece) { }
+  explicit Vector(math::LinePiece<2> const& line_piece) : Vector(cairowindow::Vector{line_piece}) { }
+
+  // Adopt the coordinates of a vector that was calculated by cairowindow.
+  explicit Vector(cairowindow::Vector const& v) : x_(v.x()), y_(v.y()) { }
+
+  constexpr double x() const { return x_; }
+  constexpr double y() const { return y_; }
+
+  operator cairowindow::Vector() const { return {x_, y_}; }
 
   // Convert the vector to a Point.
-  Point<cs> as_point() const { return {x(), y()}; }
-
-  // Call the base class implementations, but replace cairowindow::Vector with Vector.
-  double dot(Vector const& v2) const { return cairowindow::Vector::dot(v2); }
-  double cross(Vector const& v2) const { return cairowindow::Vector::cross(v2); }
-  Vector rotate_90_degrees() const { return cairowindow::Vector::rotate_90_degrees(); }
-  Vector rotate_180_degrees() const { return cairowindow::Vector::rotate_180_degrees(); }
-  Vector rotate_270_degrees() const { return cairowindow::Vector::rotate_270_degrees(); }
-  Vector& operator+=(Vector const& v2) { return static_cast<Vector&>(cairowindow::Vector::operator+=(v2)); }
-  Vector& operator-=(Vector const& v2) { return static_cast<Vector&>(cairowindow::Vector::operator-=(v2)); }
-  Vector& operator*=(double scalar) { return static_cast<Vector&>(cairowindow::Vector::operator*=(scalar)); }
-  Vector& operator/=(double scalar) { return static_cast<Vector&>(cairowindow::Vector::operator/=(scalar)); }
-  Vector operator/(double scalar) const { return cairowindow::Vector::operator/(scalar); }
-
-#ifdef CWDEBUG
+  constexpr Point<cs> as_point() const { return {x_, y_}; }
+
+  constexpr double dot(Vector const& v2) const { return x_ * v2.x_ + y_ * v2.y_; }
+  constexpr double cross(Vector const& v2) const { return x_ * v2.y_ - y_ * v2.x_; }
+  constexpr Vector rotate_90_degrees() const { return {-y_, x_}; }
+  constexpr Vector rotate_180_degrees() const { return {-x_, -y_}; }
+  constexpr Vector rotate_270_degrees() const { return {y_, -x_}; }
+  constexpr Vector& operator+=(Vector const& v2) { x_ += v2.x_; y_ += v2.y_; return *this; }
+  constexpr Vector& operator-=(Vector const& v2) { x_ -= v2.x_; y_ -= v2.y_; return *this; }
+  constexpr Vector& operator*=(double scalar) { x_ *= scalar; y_ *= scalar; return *this; }
+  constexpr Vector& operator/=(double scalar) { x_ /= scalar; y_ /= scalar; return *this; }
+  constexpr Vector operator/(double scalar) const { return {x_ / scalar, y_ / scalar}; }
+
   void print_on(std::ostream& os) const
   {
-    os << utils::to_string(cs) << ":" << cairowindow::Vector::print_on(os);
+    os << utils::to_string(cs) << ":[" << x_ << ", " << y_ << "]";
   }
-#endif
 };
 
 template<CS cs>
-inline Vector<cs> operator*(double length, Vector<cs> const& v2)
+constexpr Vector<cs> operator*(double length, Vector<cs> const& v2)
 {
-  return math::operator*(length, v2);
+  return {length * v2.x(), length * v2.y()};
 }
 
 template<CS cs>
-inline Point<cs> operator+(Point<cs> const& point, Vector<cs> const& v2)
+constexpr Point<cs> operator+(Point<cs> const& point, Vector<cs> const& v2)
 {
-  return math::operator+(point, v2);
+  return {point.x() + v2.x(), point.y() + v2.y()};
 }
 
 template<CS cs>
-inline Point<cs> operator-(Point<cs> const& point, Vector<cs> const& v2)
+constexpr Point<cs> operator-(Point<cs> const& point, Vector<cs> const& v2)
 {
-  return math::operator-(point, v2);
+  return {point.x() - v2.x(), point.y() - v2.y()};
 }
 
 template<CS cs>
-inline Vector<cs> operator+(Vector<cs> const& v1, Vector<cs> const& v2)
+constexpr Vector<cs> operator+(Vector<cs> const& v1, Vector<cs> const& v2)
 {
-  return math::operator+(v1, v2);
+  return {v1.x() + v2.x(), v1.y() + v2.y()};
 }
 
 template<CS cs>
-inline Vector<cs> operator-(Vector<cs> const& v1, Vector<cs> const& v2)
+constexpr Vector<cs> operator-(Vector<cs> const& v1, Vector<cs> const& v2)
 {
-  return math::operator-(v1, v2);
+  return {v1.x() - v2.x(), v1.y() - v2.y()};
 }
+
+static_assert(std::is_trivially_copyable_v<Vector<CS::pixels>>);
+static_assert((Point<CS::pixels>{1.0, 2.0} + Vector<CS::pixels>{3.0, 4.0}.rotate_90_degrees()).x() == -3.0,
+    "Vector must be usable in constant expressions.");
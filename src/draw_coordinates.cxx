@@ -77,8 +77,9 @@ int main()
     // Start of actual program.
 
     // Transformation from centered to pixels.
-    Transform<CS::centered, CS::pixels> const centered_transform_pixels =
+    constexpr Transform<CS::centered, CS::pixels> centered_transform_pixels =
       Transform<CS::centered, CS::pixels>{}.translate(half_window_size).scale(half_window_size.height());
+    static_assert(centered_transform_pixels.matrix().map_y(0.0, 1.0) == window_height, "(0, 1) should map to the bottom of the window");
     Dout(dc::notice, "centered_transform_pixels = " << centered_transform_pixels);
 
     Size<CS::pixels> const ObjectSize_pixels{object_width, object_height};
@@ -87,6 +88,10 @@ int main()
     Size<CS::centered> const ObjectSize_centered = ObjectSize_pixels * centered_transform_pixels.inverse();
     Dout(dc::notice, "ObjectSize_centered = " << ObjectSize_centered);
 
+    // The coordinate systems are created once; the loop below only updates them.
+    draw::CoordinateSystem<CS::centered> centered_coordinate_system(centered_transform_pixels, LineStyle({.line_color = color::green, .line_width = 1.0}));
+    draw::CoordinateSystem<CS::painter> painter_coordinate_system(LineStyle({.line_color = color::red, .line_width = 1.0}));
+
     for (double a = 0.0; a < 360.0; a += 15.0)
     {
       auto const painter_transform_centered = Transform<CS::painter, CS::centered>{}.translate(-0.5 * TranslationVector{ObjectSize_centered}).rotate(a);
@@ -98,19 +103,21 @@ int main()
       Point<CS::centered> PainterOrigin_centered = PainterOrigin_painter * painter_transform_centered;
       Dout(dc::notice, "PainterOrigin_centered = " << PainterOrigin_centered);
 
-      auto const painter_transform_pixels = painter_transform_centered * centered_transform_pixels;
+      // The product is a lazy TransformChain; collapse it here once because it is used several times below.
+      Transform<CS::painter, CS::pixels> const painter_transform_pixels = painter_transform_centered * centered_transform_pixels;
       Dout(dc::notice, "painter_transform_pixels = " << painter_transform_pixels);
 
       Size<CS::painter> const ObjectSize_painter = ObjectSize_pixels * painter_transform_pixels.inverse();
       Dout(dc::notice, "ObjectSize_painter = " << ObjectSize_painter);
 
-      // Display the painter-coordinate-system.
-      draw::CoordinateSystem<CS::centered> centered_coordinate_system(centered_transform_pixels, LineStyle({.line_color = color::green, .line_width = 1.0}));
-      centered_coordinate_system.display(layer);
+      // Display the centered-coordinate-system. This only draws something the first time, because its transform never changes.
+      DirtyRegion dirty_region = centered_coordinate_system.display(layer);
 
       // Display the painter-coordinate-system.
-      draw::CoordinateSystem<CS::painter> painter_coordinate_system(painter_transform_pixels, LineStyle({.line_color = color::red, .line_width = 1.0}));
-      painter_coordinate_system.display(layer);
+      painter_coordinate_system.set_transform(painter_transform_pixels);
+      dirty_region.add(painter_coordinate_system.display(layer));
+      // Only this part of the layer changed.
+      Dout(dc::notice, "Coordinate systems dirty_region = " << dirty_region);
 
       // Display the rectangle of ObjectSize_centered (centered-coordinate-system) with the top-left in the origin of the painter-coordinate-system (PainterOrigin).
       auto object1 = draw_rectangle(layer, painter_transform_pixels, PainterOrigin_painter, ObjectSize_painter, RectangleStyle({.line_color = color::black}));
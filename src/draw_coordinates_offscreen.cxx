@@ -0,0 +1,144 @@
+#include "sys.h"
+#include "CoordinateSystem.h"
+#include "OffscreenRenderer.h"
+#include "Transform.h"
+#include "Stopwatch.h"
+#include "Profiler.h"
+#include "TraceBuffer.h"
+#include "utils/AIAlert.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "debug.h"
+
+// Render the same angle sweep as draw_coordinates, without a window and without waiting for input, and time each frame.
+//
+// Usage: draw_coordinates_offscreen [image|png|svg [output_directory [angle_step]]]
+//
+// The default is `image`: render to memory only, which is what you want for benchmarking.
+// With png or svg every frame is written to output_directory/frame_NNN.png (or .svg).
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  Dout(dc::notice, "Entering main()");
+
+  using Format = OffscreenRenderer::Format;
+  using LineStyle = cairowindow::draw::LineStyle;
+  namespace color = cairowindow::color;
+
+  Format format = Format::image;
+  char const* extension = "";
+  if (argc > 1)
+  {
+    if (std::strcmp(argv[1], "png") == 0)
+    {
+      format = Format::png;
+      extension = ".png";
+    }
+    else if (std::strcmp(argv[1], "svg") == 0)
+    {
+      format = Format::svg;
+      extension = ".svg";
+    }
+    else if (std::strcmp(argv[1], "image") != 0)
+    {
+      std::cerr << "Usage: " << argv[0] << " [image|png|svg [output_directory [angle_step]]]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::string const output_directory = argc > 2 ? argv[2] : ".";
+  double const angle_step = argc > 3 ? std::atof(argv[3]) : 15.0;
+  if (!(angle_step > 0.0))
+  {
+    std::cerr << "angle_step must be positive." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    OffscreenRenderer renderer(format, window_width, window_height);
+
+    // The same transforms as in draw_coordinates.
+    constexpr Transform<CS::centered, CS::pixels> centered_transform_pixels =
+      Transform<CS::centered, CS::pixels>{}.translate(half_window_size).scale(half_window_size.height());
+    Size<CS::pixels> const ObjectSize_pixels{object_width, object_height};
+    Size<CS::centered> const ObjectSize_centered = ObjectSize_pixels * centered_transform_pixels.inverse();
+
+    draw::CoordinateSystem<CS::centered> centered_coordinate_system(centered_transform_pixels, LineStyle({.line_color = color::green, .line_width = 1.0}));
+    draw::CoordinateSystem<CS::painter> painter_coordinate_system(LineStyle({.line_color = color::red, .line_width = 1.0}));
+    LineStyle const rectangle_style({.line_color = color::black, .line_width = 1.0});
+
+    Stopwatch total_layout;
+    Stopwatch total_render;
+    Stopwatch total_output;
+    int frames = 0;
+
+    std::printf("%5s %12s %12s %12s\n", "angle", "layout [us]", "render [us]", "output [us]");
+    for (double a = 0.0; a < 360.0; a += angle_step, ++frames)
+    {
+      Stopwatch layout;
+      Stopwatch render;
+      Stopwatch output;
+
+      // Calculate the geometry of this frame.
+      layout.start();
+      auto const painter_transform_centered = Transform<CS::painter, CS::centered>{}.translate(-0.5 * TranslationVector{ObjectSize_centered}).rotate(a);
+      Transform<CS::painter, CS::pixels> const painter_transform_pixels = painter_transform_centered * centered_transform_pixels;
+      painter_coordinate_system.set_transform(painter_transform_pixels);
+      Size<CS::painter> const ObjectSize_painter = ObjectSize_pixels * painter_transform_pixels.inverse();
+      Point<CS::painter> const topleft_painter;
+      Point<CS::painter> const bottomright_painter = topleft_painter + ObjectSize_painter;
+      std::array<Point<CS::pixels>, 4> const corners = {
+        topleft_painter * painter_transform_pixels,
+        Point<CS::painter>{bottomright_painter.x(), topleft_painter.y()} * painter_transform_pixels,
+        bottomright_painter * painter_transform_pixels,
+        Point<CS::painter>{topleft_painter.x(), bottomright_painter.y()} * painter_transform_pixels
+      };
+      layout.stop();
+
+      char filename[32];
+      std::snprintf(filename, sizeof(filename), "/frame_%03d", frames);
+
+      // Rasterize it.
+      render.start();
+      renderer.begin_frame(output_directory + filename + extension, color::white);
+      renderer.draw(centered_coordinate_system);
+      renderer.draw(painter_coordinate_system);
+      for (int i = 0; i < 4; ++i)
+        renderer.draw_line(corners[i], corners[(i + 1) % 4], rectangle_style);
+      render.stop();
+
+      // Write the file (if any).
+      output.start();
+      renderer.end_frame();
+      output.stop();
+
+      std::printf("%5g %12.1f %12.1f %12.1f\n", a, layout.ns_per(1000), render.ns_per(1000), output.ns_per(1000));
+      total_layout.add(layout);
+      total_render.add(render);
+      total_output.add(output);
+    }
+
+    std::printf("%d frames; average per frame: layout %.1f us, render %.1f us, output %.1f us.\n", frames,
+        total_layout.ns_per(1000 * frames), total_render.ns_per(1000 * frames), total_output.ns_per(1000 * frames));
+    // Only prints something when configured with -DEnableProfiling=ON.
+    PROFILE_REPORT(std::cout);
+#ifdef TRANSFORM_BINARY_TRACE
+    // Format the trace events of the sweep.
+    std::ofstream trace_file(output_directory + "/trace.txt");
+    TRACE_DUMP(trace_file);
+#endif
+  }
+  catch (AIAlert::Error const& error)
+  {
+    Dout(dc::warning, error);
+    std::cerr << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Dout(dc::notice, "Leaving main()");
+}
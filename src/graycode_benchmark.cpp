@@ -0,0 +1,170 @@
+#include "sys.h"
+#include "GrayCode.h"
+#include "Stopwatch.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include "debug.h"
+
+// Enumerate all n-bit Gray codes with visit_gray_cycle, with visit_gray_range over chunks, with
+// visit_gray_blocks and with parallel_visit_gray_blocks, and report the number of codes per second
+// (per core for the parallel version). All methods must visit the same code at the same step.
+//
+// Usage: graycode_benchmark [n [number_of_threads]]
+
+namespace {
+
+constexpr std::size_t block_size = 64;
+constexpr unsigned checked_n = 14;              // Compare the code of every step for this n.
+constexpr uint64_t chunk_size = uint64_t{1} << 16;
+
+int failures = 0;
+
+// An order independent checksum of the visited codes.
+constexpr uint64_t hash(uint64_t g)
+{
+  return g ^ (g >> 7) ^ (g << 13);
+}
+
+struct ChecksumVisitor
+{
+  uint64_t checksum = 0;
+
+  void operator()(std::span<uint64_t const, block_size> codes, uint64_t)
+  {
+    for (uint64_t g : codes)
+      checksum += hash(g);
+  }
+};
+
+// Records the code of every step in a vector that is shared between threads; every step is written once.
+struct RecordingVisitor
+{
+  std::vector<uint64_t>* codes;
+
+  void operator()(std::span<uint64_t const, block_size> block, uint64_t k)
+  {
+    std::copy(block.begin(), block.end(), codes->begin() + k);
+  }
+};
+
+void check_order(unsigned number_of_threads)
+{
+  uint64_t const count = uint64_t{1} << checked_n;
+  std::vector<uint64_t> expected(count);
+  visit_gray_cycle(checked_n, [&](uint64_t g, uint64_t k){ expected[k] = g; });
+
+  auto compare = [&](std::vector<uint64_t> const& result, char const* method){
+    if (result != expected)
+    {
+      std::cerr << method << " does not visit the same codes as visit_gray_cycle." << std::endl;
+      ++failures;
+    }
+  };
+
+  // Chunks of an odd size, so that they don't start at a power of two.
+  std::vector<uint64_t> result(count);
+  for (uint64_t k0 = 0; k0 < count; k0 += 1000)
+    visit_gray_range(k0, std::min(k0 + 1000, count), [&](uint64_t g, uint64_t k){ result[k] = g; });
+  compare(result, "visit_gray_range");
+
+  std::ranges::fill(result, 0);
+  visit_gray_blocks<block_size>(0, count, RecordingVisitor{&result});
+  compare(result, "visit_gray_blocks");
+
+  std::ranges::fill(result, 0);
+  parallel_visit_gray_blocks<block_size>(checked_n, number_of_threads, RecordingVisitor{&result}, 256);
+  compare(result, "parallel_visit_gray_blocks");
+}
+
+void report(char const* method, Stopwatch const& stopwatch, uint64_t count, unsigned number_of_threads = 1)
+{
+  double const codes_per_second = count / stopwatch.elapsed_seconds();
+  std::cout << std::setw(28) << std::left << method << std::right << std::setw(10) << number_of_threads <<
+    std::setw(14) << stopwatch.ns_per(count) << std::setw(16) << codes_per_second * 1e-6 <<
+    std::setw(16) << codes_per_second * 1e-6 / number_of_threads << '\n';
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  unsigned const n = argc > 1 ? std::stoul(argv[1]) : 28;
+  unsigned const max_threads = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+  if (n < 6 || n > 40)
+  {
+    std::cerr << "n must be in the range [6, 40]." << std::endl;
+    return EXIT_FAILURE;
+  }
+  uint64_t const count = uint64_t{1} << n;
+
+  check_order(max_threads);
+
+  std::cout << "n = " << n << " (" << count << " codes)\n";
+  std::cout << "method                         threads       ns/code    Mcodes/sec  Mcodes/sec/core\n";
+
+  // The baseline: one code at a time.
+  Stopwatch sequential;
+  uint64_t expected = 0;
+  sequential.start();
+  visit_gray_cycle(n, [&](uint64_t g, uint64_t){ expected += hash(g); });
+  sequential.stop();
+  do_not_optimize(expected);
+  report("visit_gray_cycle", sequential, count);
+
+  Stopwatch chunked;
+  uint64_t checksum = 0;
+  chunked.start();
+  for (uint64_t k0 = 0; k0 < count; k0 += chunk_size)
+    visit_gray_range(k0, std::min(k0 + chunk_size, count), [&](uint64_t g, uint64_t){ checksum += hash(g); });
+  chunked.stop();
+  report("visit_gray_range", chunked, count);
+  if (checksum != expected)
+  {
+    std::cerr << "visit_gray_range: wrong checksum." << std::endl;
+    ++failures;
+  }
+
+  Stopwatch blocks;
+  ChecksumVisitor block_visitor;
+  blocks.start();
+  visit_gray_blocks<block_size>(0, count, block_visitor);
+  blocks.stop();
+  report("visit_gray_blocks", blocks, count);
+  if (block_visitor.checksum != expected)
+  {
+    std::cerr << "visit_gray_blocks: wrong checksum." << std::endl;
+    ++failures;
+  }
+
+  // 1, 2, 4, ... threads, ending with max_threads.
+  for (unsigned number_of_threads = 1;; number_of_threads = std::min(2 * number_of_threads, max_threads))
+  {
+    Stopwatch parallel;
+    parallel.start();
+    std::vector<ChecksumVisitor> visitors = parallel_visit_gray_blocks<block_size>(n, number_of_threads, ChecksumVisitor{}, chunk_size);
+    parallel.stop();
+    report("parallel_visit_gray_blocks", parallel, count, number_of_threads);
+    uint64_t sum = 0;
+    for (ChecksumVisitor const& visitor : visitors)
+      sum += visitor.checksum;
+    if (sum != expected)
+    {
+      std::cerr << "parallel_visit_gray_blocks with " << number_of_threads << " threads: wrong checksum." << std::endl;
+      ++failures;
+    }
+    if (number_of_threads == max_threads)
+      break;
+  }
+
+  std::cout << failures << " failures." << std::endl;
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,4 +1,5 @@
 #include "sys.h"
+#include "GrayCodeIntersection.h"
 #include "cairowindow/intersection_points.h"
 #include "math/Hyperblock.h"
 #include "utils/print_using.h"
@@ -22,4 +23,8 @@ int main()
 
   auto intersections = hypercube.intersection_points(hyperplane);
   Dout(dc::notice, "intersections = " << intersections.size());
+
+  // The same, walking the corners in Gray code order.
+  GrayCodeIntersection<n> gray_code_intersection({0, 0, 0, 0, 0, 0, 0}, {1, 1, 1, 1, 1, 1, 1}, {1, 1, 1, 1, 1, 1, 1});
+  Dout(dc::notice, "gray code intersections = " << gray_code_intersection.intersection_points(-3.5).size());
 }
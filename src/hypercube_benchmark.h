@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Helpers shared by the hypercube_* benchmark programs.
+
+namespace hypercube_benchmark {
+
+inline int failures = 0;
+
+// Call f.template operator()<n>() for n = first, first + 1, ..., last.
+template<int first, int last, typename F>
+void for_each_dimension(F&& f)
+{
+  [&]<int... i>(std::integer_sequence<int, i...>){ (f.template operator()<first + i>(), ...); }(std::make_integer_sequence<int, last - first + 1>{});
+}
+
+// Sort the points so that two results can be compared independent of the order of the edges.
+template<int n>
+void sort_points(std::vector<std::array<double, n>>& points)
+{
+  for (auto& point : points)
+    for (double& x : point)
+      x = std::round(x * 1e9) * 1e-9;
+  std::sort(points.begin(), points.end());
+}
+
+// Compare the intersection points of the plane with offset with those of a reference implementation
+// (for example math::Hyperblock<n>::intersection_points), and count a failure if they differ.
+template<int n, typename Reference>
+void check_points(std::vector<std::array<double, n>> result, Reference const& expected, double offset)
+{
+  std::vector<std::array<double, n>> reference(expected.begin(), expected.end());
+  sort_points<n>(result);
+  sort_points<n>(reference);
+  if (result != reference)
+  {
+    std::cerr << "n = " << n << ", offset = " << offset << ": " << result.size() << " points instead of " << reference.size() << std::endl;
+    ++failures;
+  }
+}
+
+// Print the number of failures and return the exit code of the program.
+inline int exit_status()
+{
+  std::cout << failures << " failures." << std::endl;
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace hypercube_benchmark
@@ -0,0 +1,120 @@
+#include "sys.h"
+#include "GrayCodeIntersection.h"
+#include "HyperplaneSweep.h"
+#include "Stopwatch.h"
+#include "hypercube_benchmark.h"
+#include "cairowindow/intersection_points.h"
+#include "math/Hyperblock.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <utility>
+#include <vector>
+#include "debug.h"
+
+// Intersect the unit n-cube with the hyperplane x1 + ... + xn + offset = 0 using GrayCodeIntersection,
+// for n = 3..24, and report the time per corner. The intersection points are cross-checked against
+// math::Hyperblock<n>::intersection_points for small n, and the number of crossed edges against
+// HyperplaneSweep for medium n.
+
+namespace {
+
+constexpr int max_cross_checked_n = 10;         // Compare the points with Hyperblock<n>.
+constexpr int max_counted_n = 16;               // Compare the number of crossed edges with HyperplaneSweep.
+
+using namespace hypercube_benchmark;
+
+template<int n>
+void benchmark()
+{
+  std::array<double, n> lo;
+  std::array<double, n> hi;
+  std::array<double, n> normal;
+  for (int k = 0; k < n; ++k)
+  {
+    lo[k] = -0.5 * k;
+    hi[k] = 1.0 + 0.25 * k;
+    normal[k] = 1.0 + std::sin(k);              // Not all the same, so that the corner values are not integers.
+  }
+
+  GrayCodeIntersection<n> engine(lo, hi, normal);
+  math::Hyperblock<n> hyperblock(lo, hi);
+
+  // A few planes through the middle part of the hyperblock.
+  double min_value = 0.0;
+  double max_value = 0.0;
+  for (int k = 0; k < n; ++k)
+  {
+    min_value += normal[k] * lo[k];
+    max_value += normal[k] * hi[k];
+  }
+  constexpr int number_of_offsets = 5;
+  Stopwatch corners;
+  Stopwatch edges;
+  Stopwatch dot_products;
+  uint64_t crossed = 0;
+  for (int i = 0; i < number_of_offsets; ++i)
+  {
+    double const offset = -(min_value + (max_value - min_value) * (i + 1) / (number_of_offsets + 1));
+
+    corners.start();
+    engine.set_offset(offset);
+    corners.stop();
+
+    // For comparison: the sign of every corner from an n-term dot product.
+    dot_products.start();
+    uint64_t negative = 0;
+    for (uint64_t c = 0; c < (uint64_t{1} << n); ++c)
+    {
+      double v = offset;
+      for (int k = 0; k < n; ++k)
+        v += normal[k] * ((c >> k & 1) ? hi[k] : lo[k]);
+      negative += v < 0.0;
+    }
+    dot_products.stop();
+    do_not_optimize(negative);
+
+    uint64_t count = 0;
+    edges.start();
+    uint64_t const crossed_now = engine.for_each_crossed_edge([&count](uint64_t, int){ ++count; });
+    edges.stop();
+    crossed += crossed_now;
+
+    if constexpr (n <= max_cross_checked_n)
+      check_points<n>(engine.intersection_points(offset), hyperblock.intersection_points(math::Hyperplane<n>(normal, offset)), offset);
+    else if constexpr (n <= max_counted_n)
+    {
+      HyperplaneSweep<n> sweep(lo, hi, normal);
+      std::size_t const expected_count = sweep.intersection_points(offset).size();
+      if (crossed_now != expected_count)
+      {
+        std::cerr << "n = " << n << ", offset = " << offset << ": " << crossed_now << " crossed edges instead of " << expected_count << std::endl;
+        ++failures;
+      }
+    }
+  }
+
+  uint64_t const total_corners = (uint64_t{1} << n) * number_of_offsets;
+  std::cout << std::setw(2) << n << std::setw(14) << crossed / number_of_offsets <<
+    std::setw(14) << corners.ns_per(total_corners) << std::setw(14) << edges.ns_per(total_corners) <<
+    std::setw(14) << dot_products.ns_per(total_corners) <<
+    std::setw(14) << (corners.elapsed_seconds() + edges.elapsed_seconds()) * 1e3 / number_of_offsets << '\n';
+}
+
+} // namespace
+
+int main()
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  // walk: GrayCodeIntersection::set_offset; edges: for_each_crossed_edge; dot: the n-term dot product per corner (all in ns).
+  std::cout << " n   edges/plane   walk/corner  edges/corner    dot/corner      ms/plane\n";
+  for_each_dimension<3, 24>([]<int n>(){ benchmark<n>(); });
+
+  return exit_status();
+}
@@ -0,0 +1,89 @@
+#include "sys.h"
+#include "HyperplaneSweep.h"
+#include "Stopwatch.h"
+#include "hypercube_benchmark.h"
+#include "cairowindow/intersection_points.h"
+#include "math/Hyperblock.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <utility>
+#include <vector>
+#include "debug.h"
+
+// Sweep the hyperplane x1 + ... + xn + offset = 0 through the unit n-cube, for n = 3..16, and report
+// the time per offset of HyperplaneSweep and of math::Hyperblock<n>::intersection_points.
+// For small n the results of both are compared.
+
+namespace {
+
+constexpr int number_of_offsets = 1000;
+constexpr int max_cross_checked_n = 8;
+
+using namespace hypercube_benchmark;
+
+template<int n>
+void benchmark()
+{
+  std::array<double, n> lo;
+  std::array<double, n> hi;
+  std::array<double, n> normal;
+  lo.fill(0.0);
+  hi.fill(1.0);
+  normal.fill(1.0);
+
+  // Offsets from just above -n to just below 0; irrational steps avoid planes that go exactly through corners.
+  std::vector<double> offsets(number_of_offsets);
+  for (int i = 0; i < number_of_offsets; ++i)
+    offsets[i] = -n + n * (i + std::numbers::sqrt2 / 2) / number_of_offsets;
+
+  Stopwatch setup;
+  setup.start();
+  HyperplaneSweep<n> sweep(lo, hi, normal);
+  setup.stop();
+
+  Stopwatch incremental;
+  uint64_t total_points = 0;
+  incremental.start();
+  for (double offset : offsets)
+    total_points += sweep.intersection_points(offset).size();
+  incremental.stop();
+
+  // Recalculating everything from scratch takes n·2^(n-1) edge tests per offset; limit the number of offsets for large n.
+  int const from_scratch_offsets = std::clamp(int((uint64_t{1} << 24) / (uint64_t{n} << n)), 1, number_of_offsets);
+  int const stride = number_of_offsets / from_scratch_offsets;
+  math::Hyperblock<n> hyperblock(lo, hi);
+  Stopwatch from_scratch;
+  int count = 0;
+  for (int i = 0; i < number_of_offsets; i += stride, ++count)
+  {
+    math::Hyperplane<n> hyperplane(normal, offsets[i]);
+    from_scratch.start();
+    auto expected = hyperblock.intersection_points(hyperplane);
+    from_scratch.stop();
+    if constexpr (n <= max_cross_checked_n)
+      check_points<n>(sweep.intersection_points(offsets[i]), expected, offsets[i]);
+  }
+
+  std::cout << std::setw(2) << n << std::setw(12) << double(total_points) / number_of_offsets <<
+    std::setw(14) << setup.elapsed_seconds() * 1e6 <<
+    std::setw(14) << incremental.ns_per(number_of_offsets) * 1e-3 <<
+    std::setw(14) << from_scratch.ns_per(count) * 1e-3 << '\n';
+}
+
+} // namespace
+
+int main()
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  std::cout << " n  points/plane      setup/us  sweep/offset  scratch/offset (us)\n";
+  for_each_dimension<3, 16>([]<int n>(){ benchmark<n>(); });
+
+  return exit_status();
+}